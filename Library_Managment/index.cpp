@@ -2,6 +2,13 @@
 #include <chrono>
 #include <shared_mutex>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 using namespace std;
 
 class InterfaceBook{
@@ -59,24 +66,12 @@ class Book : public InterfaceBook{
         }
 };
 
-class Loan{
-    public:
-        int bookId;
-        chrono::system_clock::time_point borrowedAt;
-
-        Loan(int bid, chrono::system_clock::time_point tt){
-            bookId = bid;
-            borrowedAt = tt;
-        }
-};
-
 class InterfaceMember{
     protected:
         int id;
         string name, email, phone;
 
         int maxBorrow;
-        vector<Loan *> borrowedBooks;
     public:
         virtual void setId      (int x)     = 0;
         virtual void setName    (string x)  = 0;
@@ -90,7 +85,7 @@ class InterfaceMember{
         virtual string getEmail     ()  = 0;
         virtual string getPhone     ()  = 0;
         virtual int getBorrow       ()  = 0;
-        virtual const vector<Loan*>& getLoans() = 0;
+        virtual ~InterfaceMember() = default;
 
 };
 
@@ -108,113 +103,1830 @@ class Member : public InterfaceMember{
         string getEmail     ()  { return email; }
         string getPhone     ()  { return phone; }
         int getBorrow       ()  { return maxBorrow; }
-        const vector<Loan*>& getLoans() {return borrowedBooks; }
-        bool canBorrow(){ return borrowedBooks.size() < maxBorrow; }
 
-        void borrowBook(int bid){
-            Loan *ll = new Loan(bid, chrono::system_clock::now());
-            borrowedBooks.push_back(ll);
+        Member(int _id,string _name,string _email,string _phone,int _max=5){
+            id = _id; 
+            name = _name; 
+            email = _email; 
+            phone = _phone;
+            maxBorrow = _max;
+        }
+};
+
+/*
+    Columnar Catalog:
+        - Every field of every book lives in its own column (struct-of-arrays)
+          and a book id is simply the row number, so no hashing on lookup.
+        - Strings are copied once into an append-only arena made of fixed
+          blocks. Blocks never move, so the string_views handed out stay valid
+          for the lifetime of the store.
+        - Authors & publishers repeat a lot, so they are interned and every row
+          points at the same bytes.
+*/
+class StringArena{
+        static constexpr size_t BLOCK = 64 * 1024;
+
+        vector<unique_ptr<char[]>>  blocks, large;
+        size_t                      used{BLOCK};
+        size_t                      total{0};
+    public:
+        string_view put(string_view s){
+            if(s.empty())
+                return {};
+
+            if(s.size() > BLOCK / 4){       // Large strings get a block of their own
+                large.emplace_back(new char[s.size()]);
+                memcpy(large.back().get(), s.data(), s.size());
+                total += s.size();
+                return string_view(large.back().get(), s.size());
+            }
+
+            if(used + s.size() > BLOCK){
+                blocks.emplace_back(new char[BLOCK]);
+                used = 0;
+                total += BLOCK;
+            }
+
+            char *dst = blocks.back().get() + used;
+            memcpy(dst, s.data(), s.size());
+            used += s.size();
+            return string_view(dst, s.size());
+        }
+
+        size_t bytes() const { return total; }
+};
+
+/*
+    A column that never moves: fixed-size chunks reached through a directory
+    allocated up front. Growing it (one writer at a time) never relocates an
+    element another thread is reading, so the borrow/return path can index
+    columns without the catalog lock. size() is published with release after
+    the new element is written.
+*/
+template<typename T>
+class ChunkedVector{
+        static constexpr size_t CHUNK_BITS = 12, CHUNK = size_t(1) << CHUNK_BITS, DIR = 4096;
+
+        unique_ptr<atomic<T*>[]>    dir{new atomic<T*>[DIR]()};
+        size_t                      chunks{0};
+        atomic<size_t>              count{0};
+
+        void grow(size_t n){
+            if(n > MAX)
+                throw length_error("column is full");
+            while(chunks * CHUNK < n)
+                dir[chunks++].store(new T[CHUNK](), memory_order_release);
+        }
+
+    public:
+        static constexpr size_t MAX = CHUNK * DIR;
+
+        ChunkedVector() = default;
+        ChunkedVector(const ChunkedVector&) = delete;
+        ChunkedVector& operator=(const ChunkedVector&) = delete;
+        ~ChunkedVector(){
+            for(size_t c = 0; c < chunks; c++)
+                delete[] dir[c].load();
+        }
+
+        size_t size    () const { return count.load(memory_order_acquire); }
+        size_t capacity() const { return chunks * CHUNK; }
+
+        T&       operator[](size_t i)       { return dir[i >> CHUNK_BITS].load(memory_order_acquire)[i & (CHUNK - 1)]; }
+        const T& operator[](size_t i) const { return dir[i >> CHUNK_BITS].load(memory_order_acquire)[i & (CHUNK - 1)]; }
+
+        void push_back(const T& x){
+            size_t n = count.load(memory_order_relaxed);
+            grow(n + 1);
+            (*this)[n] = x;
+            count.store(n + 1, memory_order_release);
+        }
+
+        // Grows to `n` value-initialized elements; never shrinks
+        void resize(size_t n){
+            if(n <= count.load(memory_order_relaxed))
+                return;
+            grow(n);
+            count.store(n, memory_order_release);
+        }
+};
+
+class BookStore{
+        StringArena                                 arena;
+        unordered_map<string_view, string_view>     interned;
+
+        ChunkedVector<string_view>  titles, authors, publishers, isbns;
+        ChunkedVector<int>          years;
+        ChunkedVector<uint8_t>      availableCol, liveCol;      // Written under the book's stripe
+        atomic<int>                 published{0};               // Rows below it are complete; see commit()
+
+        string_view intern(string_view s){
+            auto it = interned.find(s);
+            if(it != interned.end())
+                return it->second;
+
+            string_view v = arena.put(s);
+            interned.emplace(v, v);
+            return v;
+        }
+
+    public:
+        BookStore(){
+            push("", "", "", "", 0, false);     // Row 0 is never a book so ids start at 1
+            liveCol[0] = 0;
+            commit();
+        }
+
+        int push(string_view title, string_view author, string_view publisher, string_view isbn, int year, bool avail=true){
+            titles.push_back(arena.put(title));
+            authors.push_back(intern(author));
+            publishers.push_back(intern(publisher));
+            isbns.push_back(arena.put(isbn));
+            years.push_back(year);
+            availableCol.push_back(avail);
+            liveCol.push_back(1);
+            return (int)years.size() - 1;
+        }
+
+        // Like push() but keeps the caller's bytes; they must outlive the store (e.g. a mapped snapshot)
+        int adopt(string_view title, string_view author, string_view publisher, string_view isbn, int year, bool avail, bool live){
+            titles.push_back(title);
+            authors.push_back(author);
+            publishers.push_back(publisher);
+            isbns.push_back(isbn);
+            years.push_back(year);
+            availableCol.push_back(avail);
+            liveCol.push_back(live);
+            return (int)years.size() - 1;
+        }
+
+        // Makes the rows pushed so far visible to size()/contains(), once the caller has indexed them
+        void commit() { published.store((int)years.size(), memory_order_release); }
+
+        void erase(int id) { liveCol[id] = 0; }
+
+        bool inRange (int id) const { return id > 0 && id < size(); }
+        bool contains(int id) const { return inRange(id) && liveCol[id]; }
+        int  size() const { return published.load(memory_order_acquire); }   // One past the largest committed id
+
+        string_view title       (int id) const { return titles[id]; }
+        string_view author      (int id) const { return authors[id]; }
+        string_view publisher   (int id) const { return publishers[id]; }
+        string_view isbn        (int id) const { return isbns[id]; }
+        int         year        (int id) const { return years[id]; }
+        bool        available   (int id) const { return availableCol[id]; }
+
+        void setAvailable(int id, bool x) { availableCol[id] = x; }
+
+        size_t bytes() const {
+            return arena.bytes()
+                 + interned.size() * 2 * sizeof(string_view)
+                 + titles.capacity() * 4 * sizeof(string_view)
+                 + years.capacity() * (sizeof(int) + 2 * sizeof(uint8_t));
+        }
+};
+
+/*
+    Secondary Indexes:
+        - isbn      -> book id      (hash)
+        - author    -> book ids     (hash, authors interned to small ints)
+        - year      -> book ids     (sorted map, answers ranges)
+        - available                 (bitmap, one bit per book id)
+
+    The year & author of every book are also kept in plain arrays indexed by
+    id, so once the cheapest index has produced a candidate list the other
+    predicates are checked without touching a Book* or a virtual getter.
+*/
+class BookQuery{
+    public:
+        optional<string>         isbn, author;
+        optional<pair<int, int>> years;
+        bool                     onlyAvailable{false};
+
+        BookQuery& byIsbn           (string x)          { isbn = move(x); return *this; }
+        BookQuery& byAuthor         (string x)          { author = move(x); return *this; }
+        BookQuery& publishedBetween (int lo, int hi)    { years = make_pair(lo, hi); return *this; }
+        BookQuery& available        ()                  { onlyAvailable = true; return *this; }
+};
+
+class BookIndex{
+        static constexpr int NONE = INT_MIN;
+
+        unordered_map<string_view, int> isbnIndex;      // Keys point into the BookStore arena
+        unordered_map<string_view, int> authorIds;
+        vector<vector<int>>         authorIndex;        // authorId -> book ids
+        map<int, vector<int>>       yearIndex;          // year -> book ids
+        vector<int>                 yearOf, authorOf;   // book id -> column value, NONE if absent
+        ChunkedVector<atomic<uint64_t>> availableBits;  // Atomic so borrows of different books never need a common lock
+        int                         liveCount{0};
+        atomic<int>                 availableCount{0};
+
+        bool exists(int id) const { return id >= 0 && id < (int)yearOf.size() && yearOf[id] != NONE; }
+
+        static void eraseId(vector<int>& v, int id){
+            auto it = find(v.begin(), v.end(), id);
+            if(it != v.end()){
+                *it = v.back();
+                v.pop_back();
+            }
+        }
+
+    public:
+        void add(int id, string_view isbn, string_view author, int year, bool avail){
+            if(id >= (int)yearOf.size()){
+                yearOf.resize(id + 1, NONE);
+                authorOf.resize(id + 1, NONE);
+                availableBits.resize(id / 64 + 1);
+            }
+
+            auto ins = authorIds.emplace(author, (int)authorIndex.size());
+            if(ins.second)
+                authorIndex.emplace_back();
+            int aid = ins.first->second;
+
+            isbnIndex[isbn] = id;
+            authorIndex[aid].push_back(id);
+            yearIndex[year].push_back(id);
+            yearOf[id] = year;
+            authorOf[id] = aid;
+            liveCount++;
+            setAvailable(id, avail);
+        }
+
+        void remove(int id, string_view isbn){
+            if(!exists(id))
+                return;
+
+            setAvailable(id, false);
+            isbnIndex.erase(isbn);
+            eraseId(authorIndex[authorOf[id]], id);
+
+            auto yr = yearIndex.find(yearOf[id]);
+            eraseId(yr->second, id);
+            if(yr->second.empty())
+                yearIndex.erase(yr);
+
+            yearOf[id] = authorOf[id] = NONE;
+            liveCount--;
+        }
+
+        void setAvailable(int id, bool x){
+            uint64_t mask = 1ULL << (id % 64);
+            uint64_t prev = x ? availableBits[id / 64].fetch_or(mask) : availableBits[id / 64].fetch_and(~mask);
+            if((bool)(prev & mask) != x)
+                availableCount += x ? 1 : -1;
+        }
+
+        bool isAvailable(int id) const {
+            return exists(id) && (availableBits[id / 64].load() >> (id % 64) & 1);
+        }
+
+        /*
+            Picks the predicate with the smallest candidate set (isbn < author <
+            year range < availability < full scan), enumerates it, and filters the
+            candidates against the remaining predicates through the id columns.
+        */
+        vector<int> query(const BookQuery& q) const {
+            enum Source { ISBN, AUTHOR, YEARS, AVAILABLE, SCAN };
+
+            int aid = NONE;
+            if(q.author){
+                auto it = authorIds.find(*q.author);
+                if(it == authorIds.end())
+                    return {};
+                aid = it->second;
+            }
+            if(q.years && q.years->first > q.years->second)
+                return {};
+
+            Source src = SCAN;
+            size_t best = liveCount;
+
+            if(q.isbn){
+                src = ISBN;
+                best = 1;
+            }
+            if(q.author && authorIndex[aid].size() < best){
+                src = AUTHOR;
+                best = authorIndex[aid].size();
+            }
+            if(q.years){
+                size_t cnt = 0;
+                for(auto it = yearIndex.lower_bound(q.years->first); it != yearIndex.end() && it->first <= q.years->second && cnt < best; it++)
+                    cnt += it->second.size();
+                if(cnt < best){
+                    src = YEARS;
+                    best = cnt;
+                }
+            }
+            if(q.onlyAvailable && (size_t)availableCount.load() < best)
+                src = AVAILABLE;
+
+            int isbnId = NONE;
+            if(q.isbn){
+                auto it = isbnIndex.find(*q.isbn);
+                if(it == isbnIndex.end())
+                    return {};
+                isbnId = it->second;
+            }
+
+            vector<int> res;
+            auto check = [&](int id){
+                if(!exists(id))                                     return;
+                if(q.isbn && id != isbnId)                          return;
+                if(q.author && authorOf[id] != aid)                 return;
+                if(q.years && (yearOf[id] < q.years->first || yearOf[id] > q.years->second)) return;
+                if(q.onlyAvailable && !isAvailable(id))             return;
+                res.push_back(id);
+            };
+
+            switch(src){
+                case ISBN:
+                    check(isbnId);
+                    break;
+                case AUTHOR:
+                    for(int id : authorIndex[aid])
+                        check(id);
+                    break;
+                case YEARS:
+                    for(auto it = yearIndex.lower_bound(q.years->first); it != yearIndex.end() && it->first <= q.years->second; it++)
+                        for(int id : it->second)
+                            check(id);
+                    break;
+                case AVAILABLE:
+                    for(size_t w = 0; w < availableBits.size(); w++)
+                        for(uint64_t bits = availableBits[w].load(); bits; bits &= bits - 1)
+                            check((int)(w * 64 + __builtin_ctzll(bits)));
+                    break;
+                case SCAN:
+                    for(int id = 0; id < (int)yearOf.size(); id++)
+                        check(id);
+                    break;
+            }
+
+            sort(res.begin(), res.end());
+            return res;
+        }
+};
+
+/*
+    Loan Ledger:
+        - Loans are records in a slab (a vector with a free list), not one
+          `new` per loan, so they sit next to each other in memory.
+        - by book   : book id -> (shard, slot), a direct array lookup
+        - by member : an intrusive doubly linked list threaded through the slab
+        - by due    : a min-heap of (due, slot, generation). Returned loans are
+                      left in the heap and skipped because their generation no
+                      longer matches; the heap is rebuilt once stale entries
+                      dominate it.
+        - The ledger is split into shards by member id. Library maps each shard
+          onto the member's lock stripe, so a borrow/return never needs a lock
+          of its own for the ledger.
+*/
+struct LoanInfo{
+    int bookId, memberId;
+    chrono::system_clock::time_point borrowedAt, dueAt;
+};
+
+class LoanLedger{
+    public:
+        static constexpr int SHARDS = 64;
+        using TimePoint = chrono::system_clock::time_point;
+
+    private:
+        struct Record{
+            LoanInfo    info;
+            int         prev, next;     // Member list while live, free list while free
+            uint32_t    gen;
+            bool        live;
+        };
+
+        struct HeapEntry{
+            TimePoint   due;
+            int         slot;
+            uint32_t    gen;
+            bool operator>(const HeapEntry& o) const { return due > o.due; }
+        };
+
+        struct Shard{
+            vector<Record>              slab;
+            int                         freeHead{-1}, liveCount{0};
+            unordered_map<int, int>     memberHead;
+            vector<HeapEntry>           heap;
+
+            bool current(const HeapEntry& e) const { return slab[e.slot].live && slab[e.slot].gen == e.gen; }
+
+            void rebuildHeap(){
+                heap.clear();
+                for(int i = 0; i < (int)slab.size(); i++)
+                    if(slab[i].live)
+                        heap.push_back({slab[i].info.dueAt, i, slab[i].gen});
+                make_heap(heap.begin(), heap.end(), greater<HeapEntry>());
+            }
+        };
+
+        struct Ref{ int shard{-1}, slot{-1}; };
+
+        array<Shard, SHARDS>    shards;
+        ChunkedVector<Ref>      byBook;
+
+    public:
+        static int shardOf(int mid) { return mid % SHARDS; }
+
+        // Called when the catalog grows; requires exclusive access
+        void reserveBooks(int n){
+            if(n > (int)byBook.size())
+                byBook.resize(n);
+        }
+
+        // Caller holds the locks of book `bid` and of shardOf(mid)
+        void open(int mid, int bid, TimePoint at, TimePoint due){
+            Shard& sh = shards[shardOf(mid)];
+            int slot;
+            if(sh.freeHead != -1){
+                slot = sh.freeHead;
+                sh.freeHead = sh.slab[slot].next;
+            } else {
+                slot = sh.slab.size();
+                sh.slab.push_back({{}, -1, -1, 0, false});
+            }
+
+            auto head = sh.memberHead.emplace(mid, -1).first;
+            Record& r = sh.slab[slot];
+            r.info = {bid, mid, at, due};
+            r.live = true;
+            r.prev = -1;
+            r.next = head->second;
+            if(head->second != -1)
+                sh.slab[head->second].prev = slot;
+            head->second = slot;
+
+            sh.heap.push_back({due, slot, r.gen});
+            push_heap(sh.heap.begin(), sh.heap.end(), greater<HeapEntry>());
+            sh.liveCount++;
+            byBook[bid] = {shardOf(mid), slot};
+        }
+
+        // O(1): finds the loan through the book index and unlinks it. Fails if
+        // the book is not on loan to `mid`. Same locking as open().
+        bool close(int mid, int bid){
+            if(bid >= (int)byBook.size() || byBook[bid].shard != shardOf(mid))
+                return false;
+
+            Shard& sh = shards[byBook[bid].shard];
+            int slot = byBook[bid].slot;
+            Record& r = sh.slab[slot];
+            if(r.info.memberId != mid)
+                return false;
+
+            if(r.prev != -1) sh.slab[r.prev].next = r.next;
+            else             sh.memberHead[mid] = r.next;
+            if(r.next != -1) sh.slab[r.next].prev = r.prev;
+
+            r.live = false;
+            r.gen++;
+            r.next = sh.freeHead;
+            sh.freeHead = slot;
+            sh.liveCount--;
+            byBook[bid] = {};
+
+            if(sh.heap.size() > 64 && sh.heap.size() > 2 * (size_t)sh.liveCount)
+                sh.rebuildHeap();
+            return true;
+        }
+
+        // Caller holds the lock of shardOf(mid)
+        template<typename F>
+        void forEachOfMember(int mid, F f) const {
+            const Shard& sh = shards[shardOf(mid)];
+            auto it = sh.memberHead.find(mid);
+            for(int slot = it == sh.memberHead.end() ? -1 : it->second; slot != -1; slot = sh.slab[slot].next)
+                f(sh.slab[slot].info);
+        }
+
+        // Caller holds the lock of `shard`
+        template<typename F>
+        void forEachInShard(int shard, F f) const {
+            for(const Record& r : shards[shard].slab)
+                if(r.live)
+                    f(r.info);
+        }
+
+        int countInShard(int shard) const { return shards[shard].liveCount; }
+
+        /*
+            Overdue loans of one shard. Walks the heap as a tree and stops
+            descending as soon as a node is not overdue, so the cost is
+            proportional to the number of overdue entries, not to all loans.
+        */
+        void overdueInShard(int shard, TimePoint now, vector<LoanInfo>& out) const {
+            const Shard& sh = shards[shard];
+            vector<int> stk;
+            if(!sh.heap.empty())
+                stk.push_back(0);
+
+            while(!stk.empty()){
+                int i = stk.back();
+                stk.pop_back();
+                const HeapEntry& e = sh.heap[i];
+                if(e.due >= now)
+                    continue;
+
+                if(sh.current(e))
+                    out.push_back(sh.slab[e.slot].info);
+                for(int c = 2 * i + 1; c <= 2 * i + 2 && c < (int)sh.heap.size(); c++)
+                    stk.push_back(c);
+            }
         }
+};
+
+/*
+    Bulk Import:
+        - The file is mapped into memory (read into one buffer where mmap is
+          not available) and cut into chunks at line boundaries.
+        - Chunks are parsed in parallel. A parsed row is just string_views into
+          the mapping; only fields with escapes are unescaped into storage owned
+          by the chunk.
+        - Parsed chunks are committed in file order, each in one batch with its
+          ids reserved up front, so ids follow the file and the catalog lock is
+          taken once per chunk instead of once per book.
+
+    Formats:
+        CSV   : title,author,publisher,isbn,year   (optional header, "" quoting)
+        JSONL : {"title": "...", "author": "...", "publisher": "...", "isbn": "...", "year": 1949}
+*/
+struct BookRow{
+    string_view title, author, publisher, isbn;
+    int         year{0};
+};
+
+struct ImportStats{
+    long    rows{0}, badRows{0};
+    double  seconds{0};
+
+    double rowsPerSec() const { return seconds > 0 ? rows / seconds : 0; }
+};
+
+class MappedFile{
+        const char  *ptr{nullptr};
+        size_t      len{0};
+        string      fallback;
+    public:
+        explicit MappedFile(const string& path){
+#ifndef _WIN32
+            int fd = open(path.c_str(), O_RDONLY);
+            if(fd < 0)
+                throw runtime_error("cannot open " + path);
+
+            struct stat st;
+            fstat(fd, &st);
+            len = st.st_size;
+            if(len > 0){
+                void *p = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+                if(p == MAP_FAILED){
+                    close(fd);
+                    throw runtime_error("cannot map " + path);
+                }
+                madvise(p, len, MADV_SEQUENTIAL);
+                ptr = (const char*)p;
+            }
+            close(fd);
+#else
+            ifstream in(path, ios::binary);
+            if(!in)
+                throw runtime_error("cannot open " + path);
+            fallback.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+            ptr = fallback.data();
+            len = fallback.size();
+#endif
+        }
+
+        ~MappedFile(){
+#ifndef _WIN32
+            if(ptr)
+                munmap((void*)ptr, len);
+#endif
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        string_view view() const { return string_view(ptr, len); }
+};
+
+class CatalogImporter{
+    public:
+        enum Format { CSV, JSONL };
 
-        void returnBook(int bid) {
-            auto it = borrowedBooks.begin();
-            while (it != borrowedBooks.end()) {
-                if ((*it)->bookId == bid) {
-                    delete *it; 
-                    it = borrowedBooks.erase(it);
+        struct Chunk{
+            vector<BookRow> rows;
+            deque<string>   owned;      // Unescaped fields; deque so views stay valid
+            long            badRows{0};
+        };
+
+    private:
+        static bool toInt(string_view s, int& out){
+            while(!s.empty() && s.front() == ' ') s.remove_prefix(1);
+            while(!s.empty() && (s.back() == ' ' || s.back() == '\r')) s.remove_suffix(1);
+            auto r = from_chars(s.data(), s.data() + s.size(), out);
+            return r.ec == errc() && r.ptr == s.data() + s.size();
+        }
+
+        // One CSV field starting at `i`; leaves `i` past the separator
+        static string_view csvField(string_view line, size_t& i, Chunk& ch){
+            if(i < line.size() && line[i] == '"'){
+                size_t start = ++i;
+                bool escaped = false;
+                while(i < line.size()){
+                    if(line[i] == '"'){
+                        if(i + 1 < line.size() && line[i + 1] == '"'){
+                            escaped = true;
+                            i += 2;
+                            continue;
+                        }
+                        break;
+                    }
+                    i++;
+                }
+                string_view raw = line.substr(start, i - start);
+                size_t sep = line.find(',', i);
+                i = sep == string_view::npos ? line.size() : sep + 1;
+                if(!escaped)
+                    return raw;
+
+                string& out = ch.owned.emplace_back();
+                for(size_t k = 0; k < raw.size(); k++){
+                    out += raw[k];
+                    if(raw[k] == '"') k++;
+                }
+                return out;
+            }
+
+            size_t end = line.find(',', i);
+            if(end == string_view::npos) end = line.size();
+            string_view res = line.substr(i, end - i);
+            i = min(line.size(), end + 1);
+            return res;
+        }
+
+        static bool parseCsv(string_view line, Chunk& ch, BookRow& row){
+            size_t i = 0;
+            row.title       = csvField(line, i, ch);
+            row.author      = csvField(line, i, ch);
+            row.publisher   = csvField(line, i, ch);
+            row.isbn        = csvField(line, i, ch);
+            return toInt(csvField(line, i, ch), row.year);
+        }
+
+        // A JSON string starting after its opening quote; leaves `i` past the closing quote
+        static string_view jsonString(string_view line, size_t& i, Chunk& ch){
+            size_t start = i;
+            bool escaped = false;
+            while(i < line.size() && line[i] != '"'){
+                if(line[i] == '\\'){
+                    escaped = true;
+                    i++;
+                }
+                i++;
+            }
+            string_view raw = line.substr(start, min(i, line.size()) - start);
+            i++;
+            if(!escaped)
+                return raw;
+
+            string& out = ch.owned.emplace_back();
+            for(size_t k = 0; k < raw.size(); k++){
+                if(raw[k] != '\\' || k + 1 == raw.size()){
+                    out += raw[k];
+                    continue;
+                }
+                char c = raw[++k];
+                out += c == 'n' ? '\n' : c == 't' ? '\t' : c;
+            }
+            return out;
+        }
+
+        static bool parseJson(string_view line, Chunk& ch, BookRow& row){
+            bool hasYear = false;
+            size_t i = line.find('{');
+            if(i == string_view::npos)
+                return false;
+
+            while(true){
+                i = line.find('"', i);
+                if(i == string_view::npos)
+                    break;
+                i++;
+                string_view key = jsonString(line, i, ch);
+
+                i = line.find(':', i);
+                if(i == string_view::npos)
+                    return false;
+                i++;
+                while(i < line.size() && line[i] == ' ') i++;
+
+                if(i < line.size() && line[i] == '"'){
+                    i++;
+                    string_view val = jsonString(line, i, ch);
+                    if     (key == "title")     row.title = val;
+                    else if(key == "author")    row.author = val;
+                    else if(key == "publisher") row.publisher = val;
+                    else if(key == "isbn")      row.isbn = val;
                 } else {
-                    ++it;
+                    size_t end = line.find_first_of(",}", i);
+                    if(end == string_view::npos)
+                        return false;
+                    if(key == "year")
+                        hasYear = toInt(line.substr(i, end - i), row.year);
+                    i = end;
                 }
             }
+            return hasYear;
         }
 
+    public:
+        static Format formatOf(const string& path){
+            auto dot = path.rfind('.');
+            string ext = dot == string::npos ? "" : path.substr(dot);
+            return ext == ".jsonl" || ext == ".json" ? JSONL : CSV;
+        }
 
-        Member(int _id,string _name,string _email,string _phone,int _max=5){
-            id = _id; 
-            name = _name; 
-            email = _email; 
-            phone = _phone;
-            maxBorrow = _max;
+        static void parseChunk(string_view text, Format fmt, Chunk& ch){
+            ch.rows.reserve(text.size() / 64);
+            while(!text.empty()){
+                size_t nl = text.find('\n');
+                string_view line = text.substr(0, nl);
+                text.remove_prefix(nl == string_view::npos ? text.size() : nl + 1);
+
+                if(!line.empty() && line.back() == '\r')
+                    line.remove_suffix(1);
+                if(line.empty())
+                    continue;
+                if(fmt == CSV && line.substr(0, 6) == "title,")
+                    continue;
+
+                BookRow row;
+                if(fmt == CSV ? parseCsv(line, ch, row) : parseJson(line, ch, row))
+                    ch.rows.push_back(row);
+                else
+                    ch.badRows++;
+            }
         }
+
+        // Cuts `text` into roughly equal pieces that end on a newline
+        static vector<string_view> split(string_view text, size_t pieces){
+            vector<string_view> res;
+            size_t target = max<size_t>(1, text.size() / max<size_t>(1, pieces));
+            while(!text.empty()){
+                size_t cut = target >= text.size() ? string_view::npos : text.find('\n', target);
+                cut = cut == string_view::npos ? text.size() : cut + 1;
+                res.push_back(text.substr(0, cut));
+                text.remove_prefix(cut);
+            }
+            return res;
+        }
+};
+
+/*
+    Snapshot File (little endian, every section 8-byte aligned):
+        Header
+        SnapBook    [bookCount]     row i is book id i, row 0 unused
+        SnapMember  [memberCount]   row i is member id i, row 0 unused
+        SnapLoan    [loanCount]
+        string blob                 every string field is an (offset, length) into it
+
+    Nothing in the file is a pointer, so it can be mapped and read in place.
+    Authors & publishers shared in memory are written to the blob only once.
+
+    Hold queues are not saved, and neither is a returned book set aside for
+    the next member in line: a book that is held but not on loan is written
+    as available.
+*/
+struct SnapHeader{
+    char        magic[8];
+    uint32_t    version;
+    uint32_t    headerSize;
+    uint64_t    bookCount, memberCount, loanCount;
+    uint64_t    booksOff, membersOff, loansOff, stringsOff, stringsLen;
 };
 
+struct SnapStr{
+    uint64_t    off;
+    uint32_t    len, pad;
+};
+
+struct SnapBook{
+    SnapStr     title, author, publisher, isbn;
+    int32_t     year;
+    uint8_t     available, live, pad[2];
+};
+
+struct SnapMember{
+    SnapStr     name, email, phone;
+    int32_t     maxBorrow;
+    uint8_t     live, pad[3];
+};
+
+struct SnapLoan{
+    int32_t     bookId, memberId;
+    int64_t     borrowedAt, dueAt;      // Nanoseconds since the system_clock epoch
+};
+
+class LibrarySnapshot{
+        shared_ptr<MappedFile>  file;
+        const SnapHeader       *hdr;
+
+        template<typename T>
+        const T* section(uint64_t off, uint64_t cnt) const {
+            if(off % alignof(T) || off > file->view().size() || cnt > (file->view().size() - off) / sizeof(T))
+                throw runtime_error("corrupt snapshot section");
+            return (const T*)(file->view().data() + off);
+        }
+
+    public:
+        static constexpr char       MAGIC[8] = {'L', 'I', 'B', 'S', 'N', 'A', 'P', 0};
+        static constexpr uint32_t   VERSION = 1;
+
+        explicit LibrarySnapshot(const string& path) : file(make_shared<MappedFile>(path)) {
+            string_view v = file->view();
+            if(v.size() < sizeof(SnapHeader))
+                throw runtime_error("snapshot too small: " + path);
+
+            hdr = (const SnapHeader*)v.data();
+            if(memcmp(hdr->magic, MAGIC, 8) != 0)
+                throw runtime_error("not a library snapshot: " + path);
+            if(hdr->version != VERSION || hdr->headerSize != sizeof(SnapHeader))
+                throw runtime_error("unsupported snapshot version " + to_string(hdr->version));
+            if(hdr->stringsOff > v.size() || hdr->stringsLen > v.size() - hdr->stringsOff)
+                throw runtime_error("corrupt snapshot strings");
+
+            section<SnapBook>(hdr->booksOff, hdr->bookCount);
+            section<SnapMember>(hdr->membersOff, hdr->memberCount);
+            section<SnapLoan>(hdr->loansOff, hdr->loanCount);
+        }
+
+        size_t bookCount   () const { return hdr->bookCount; }
+        size_t memberCount () const { return hdr->memberCount; }
+        size_t loanCount   () const { return hdr->loanCount; }
+
+        const SnapBook&   book   (size_t i) const { return section<SnapBook>(hdr->booksOff, hdr->bookCount)[i]; }
+        const SnapMember& member (size_t i) const { return section<SnapMember>(hdr->membersOff, hdr->memberCount)[i]; }
+        const SnapLoan&   loan   (size_t i) const { return section<SnapLoan>(hdr->loansOff, hdr->loanCount)[i]; }
+
+        string_view str(const SnapStr& s) const {
+            if(s.off > hdr->stringsLen || s.len > hdr->stringsLen - s.off)
+                throw runtime_error("corrupt snapshot string");
+            return file->view().substr(hdr->stringsOff + s.off, s.len);
+        }
+
+        Member* materializeMember(int id) const {
+            const SnapMember& m = member(id);
+            return new Member(id, string(str(m.name)), string(str(m.email)), string(str(m.phone)), m.maxBorrow);
+        }
+};
+
+class SnapshotWriter{
+        vector<char>                        blob;
+        unordered_map<const char*, SnapStr> shared;     // Interned strings already in the blob
+
+        static void pad8(ofstream& out, uint64_t& pos){
+            static const char zeros[8] = {};
+            out.write(zeros, (8 - pos % 8) % 8);
+            pos += (8 - pos % 8) % 8;
+        }
+
+    public:
+        vector<SnapBook>    books;
+        vector<SnapMember>  members;
+        vector<SnapLoan>    loans;
+
+        SnapStr put(string_view s){
+            SnapStr r{blob.size(), (uint32_t)s.size(), 0};
+            blob.insert(blob.end(), s.begin(), s.end());
+            return r;
+        }
+
+        SnapStr putShared(string_view s){
+            auto it = shared.find(s.data());
+            if(it != shared.end() && it->second.len == s.size())
+                return it->second;
+            return shared[s.data()] = put(s);
+        }
+
+        static int64_t nanos(chrono::system_clock::time_point t){
+            return chrono::duration_cast<chrono::nanoseconds>(t.time_since_epoch()).count();
+        }
+
+        // Written to `path`.tmp and renamed over `path`, so readers never see a torn file
+        void write(const string& path){
+            string tmp = path + ".tmp";
+            ofstream out(tmp, ios::binary | ios::trunc);
+            if(!out)
+                throw runtime_error("cannot write " + tmp);
+
+            SnapHeader h{};
+            memcpy(h.magic, LibrarySnapshot::MAGIC, 8);
+            h.version = LibrarySnapshot::VERSION;
+            h.headerSize = sizeof(SnapHeader);
+            h.bookCount = books.size();
+            h.memberCount = members.size();
+            h.loanCount = loans.size();
+            h.booksOff = sizeof(SnapHeader);
+            h.membersOff = h.booksOff + books.size() * sizeof(SnapBook);
+            h.loansOff = h.membersOff + members.size() * sizeof(SnapMember);
+            h.stringsOff = h.loansOff + loans.size() * sizeof(SnapLoan);
+            h.stringsLen = blob.size();
+
+            out.write((const char*)&h, sizeof h);
+            out.write((const char*)books.data(), books.size() * sizeof(SnapBook));
+            out.write((const char*)members.data(), members.size() * sizeof(SnapMember));
+            out.write((const char*)loans.data(), loans.size() * sizeof(SnapLoan));
+            out.write(blob.data(), blob.size());
+            out.close();
+            if(!out)
+                throw runtime_error("failed writing " + tmp);
+
+            filesystem::rename(tmp, path);
+        }
+};
+
+/*
+    Hold Notifications:
+        - Same roles as Patterns/Observer.cpp: observers register with a
+          publisher and get update()d, so members stop polling BorrowBook.
+        - publish() only records the event. Only exact repeats (same book, same
+          member) inside one window are coalesced, so a book handed from X to Y
+          within the window still tells X; a flusher thread hands each observer
+          the whole batch at once, so a return storm costs one update() per
+          window instead of one per return.
+*/
+struct AvailableEvent{
+    int bookId, memberId;       // memberId is who the book is being held for
+};
+
+class AvailabilityObserver{
+    public:
+        virtual void update(const vector<AvailableEvent>& batch) = 0;
+        virtual ~AvailabilityObserver() = default;
+};
+
+class AvailabilityPublisher{
+        unordered_set<AvailabilityObserver *>   st;
+        mutex                                   observerLock;   // Held while delivering, so rmvObserver waits for it
+
+        mutex                                   pendingLock;
+        condition_variable                      cv;
+        unordered_set<uint64_t>                 pending;        // (bookId, memberId) keys already queued
+        vector<AvailableEvent>                  order;          // Pending events in first-seen order
+        chrono::milliseconds                    window;
+        size_t                                  maxBatch;
+        bool                                    stopping{false};
+        once_flag                               started;
+        thread                                  flusher;
+
+        void run(){
+            unique_lock<mutex> lk(pendingLock);
+            while(!stopping){
+                cv.wait_for(lk, window, [&]{ return stopping || order.size() >= maxBatch; });
+                lk.unlock();
+                flush();
+                lk.lock();
+            }
+        }
+
+    public:
+        explicit AvailabilityPublisher(chrono::milliseconds _window = chrono::milliseconds(50), size_t _maxBatch = 1024)
+            : window(_window), maxBatch(_maxBatch) {}
+
+        ~AvailabilityPublisher(){
+            {
+                lock_guard<mutex> lk(pendingLock);
+                stopping = true;
+            }
+            cv.notify_one();
+            if(flusher.joinable())
+                flusher.join();
+            flush();
+        }
+
+        void publish(AvailableEvent e){
+            call_once(started, [&]{ flusher = thread(&AvailabilityPublisher::run, this); });
+
+            bool full;
+            {
+                lock_guard<mutex> lk(pendingLock);
+                if(pending.insert((uint64_t)(uint32_t)e.bookId << 32 | (uint32_t)e.memberId).second)
+                    order.push_back(e);
+                full = order.size() >= maxBatch;
+            }
+            if(full)
+                cv.notify_one();
+        }
+
+        // Delivers whatever is pending right now
+        void flush(){
+            vector<AvailableEvent> batch;
+            {
+                lock_guard<mutex> lk(pendingLock);
+                batch.swap(order);
+                pending.clear();
+            }
+            if(batch.empty())
+                return;
+
+            lock_guard<mutex> lk(observerLock);
+            for(auto x : st)
+                x->update(batch);
+        }
+
+        void addObserver(AvailabilityObserver *obs){
+            lock_guard<mutex> lk(observerLock);
+            st.insert(obs);
+        }
+
+        void rmvObserver(AvailabilityObserver *obs){
+            lock_guard<mutex> lk(observerLock);
+            st.erase(obs);
+        }
+};
+
+/*
+    Concurrency:
+        - catalogLock guards the *shape* of the library (which books & members
+          exist). Adding/removing takes it exclusively; queries, reports and
+          snapshots share it. Borrow, return and holds never touch it.
+        - A borrow/return only touches one book and one member, so it locks the
+          stripe owning that book and the stripe owning that member. Two
+          terminals working on different books & members never block each other
+          and share no written cache line. Book & member slots live in chunked
+          columns that never move, so no lock is needed to reach them; removing
+          a book or member also takes its stripe, which is what the hot path
+          re-checks under.
+        - Stripes are padded to a cache line so neighbouring locks don't false share.
+        - Hold queues live in shards guarded by the book stripes, so placing a
+          hold or handing a returned book to the next member in line needs no
+          extra lock either.
+        - Members loaded from a snapshot are only turned into Member objects the
+          first time they are touched; the slot is filled with a CAS so this
+          needs no lock either.
+*/
 class Library{
     protected:
-        unordered_map<int, Book*>   books;
-        unordered_map<int, Member*> members;
-        int seqBook{1}, seqMember{1};
+        static constexpr int STRIPES = LoanLedger::SHARDS;
+
+        struct alignas(64) Stripe { mutex m; };
+
+        struct HoldShard{
+            unordered_map<int, deque<int>>  queue;      // bookId -> waiting members, FIFO
+            unordered_map<int, int>         heldFor;    // bookId -> member it was handed to on return
+        };
+
+        struct MemberSlot{
+            atomic<Member*> obj{nullptr};
+            atomic<bool>    live{false};        // Cleared by RemoveMember under the member's stripe
+        };
+
+        BookStore                   store;
+        ChunkedVector<MemberSlot>   members;            // Indexed by member id, slot 0 unused
+        shared_ptr<LibrarySnapshot> snapshot;           // Keeps the mapping alive for adopted strings
+        BookIndex                   index;
+        LoanLedger                  ledger;             // Shard i is guarded by memberStripes[i]
+        chrono::seconds             loanPeriod{chrono::hours(24 * 14)};
+        int seqMember{1};
+
+        mutable shared_mutex            catalogLock;
+        mutable array<Stripe, STRIPES>  bookStripes, memberStripes;
+        array<HoldShard, STRIPES>       holds;          // holds[i] is guarded by bookStripes[i]
+        AvailabilityPublisher           notifications;
+        ostream                        *log{&cout};
+
+        mutex& bookLock     (int bid) const { return bookStripes[bid % STRIPES].m; }
+        mutex& memberLock   (int mid) const { return memberStripes[LoanLedger::shardOf(mid)].m; }
+
+        bool memberInRange(int mid) const { return mid > 0 && mid < (int)members.size(); }
+
+        Member* findMember(int mid) const {
+            if(!memberInRange(mid) || !members[mid].live.load(memory_order_acquire))
+                return nullptr;
+
+            auto& slot = const_cast<MemberSlot&>(members[mid]);
+            Member *m = slot.obj.load(memory_order_acquire);
+            if(m || !snapshot)
+                return m;
+
+            Member *fresh = snapshot->materializeMember(mid);
+            if(slot.obj.compare_exchange_strong(m, fresh, memory_order_acq_rel))
+                return fresh;
+            delete fresh;       // Another thread materialized it first
+            return m;
+        }
+
     public:
-        int AddBook(string title, string author, string publisher, string isbn, int year){
-            Book *b = new Book(seqBook++, title, author, publisher, isbn, year, true);
-            books[seqBook-1] = b;
-            return seqBook-1;
+        ~Library(){
+            for(size_t id = 0; id < members.size(); id++)
+                delete members[id].obj.load();
+        }
+
+        // Pass nullptr to silence the per-operation messages (e.g. under load)
+        void SetLog(ostream *out) { log = out; }
+
+        void SetLoanPeriod(chrono::seconds p) { loanPeriod = p; }
+
+        int AddBook(string_view title, string_view author, string_view publisher, string_view isbn, int year){
+            unique_lock<shared_mutex> lk(catalogLock);
+            int id = store.push(title, author, publisher, isbn, year, true);
+            index.add(id, store.isbn(id), store.author(id), year, true);
+            ledger.reserveBooks(id + 1);
+            store.commit();
+            return id;
         }
 
         void RemoveBook(int id){
-            if(books.find(id) == books.end() || books[id]->getAvailable() == false){
-                cout << "This book is unavailable\n";
+            unique_lock<shared_mutex> lk(catalogLock);
+            if(!store.inRange(id)){
+                if(log) *log << "This book is unavailable\n";
                 return;
             }
+            lock_guard<mutex> bk(bookLock(id));
+            if(!store.contains(id) || store.available(id) == false){
+                if(log) *log << "This book is unavailable\n";
+                return;
+            }
+
+            index.remove(id, store.isbn(id));
+            store.erase(id);
+            if(log) *log << "Book Removed";
+        }
 
-            books.erase(books.find(id));
-            cout << "Book Removed";
+        // Commits a batch of rows under a single catalog lock; returns the first id
+        int AddBooks(const vector<BookRow>& rows){
+            unique_lock<shared_mutex> lk(catalogLock);
+            int first = store.size();
+            ledger.reserveBooks(first + rows.size());
+            for(const BookRow& r : rows){
+                int id = store.push(r.title, r.author, r.publisher, r.isbn, r.year, true);
+                index.add(id, store.isbn(id), store.author(id), r.year, true);
+            }
+            store.commit();
+            return first;
+        }
+
+        ImportStats ImportBooks(const string& path, int threads = max(1u, thread::hardware_concurrency())){
+            auto start = chrono::steady_clock::now();
+            MappedFile file(path);
+            auto fmt = CatalogImporter::formatOf(path);
+            auto pieces = CatalogImporter::split(file.view(), (size_t)threads * 4);
+
+            vector<CatalogImporter::Chunk> chunks(pieces.size());
+            vector<future<void>> parsed;
+            atomic<size_t> next{0};
+            for(int t = 0; t < threads; t++){
+                parsed.push_back(async(launch::async, [&]{
+                    for(size_t i; (i = next++) < pieces.size(); )
+                        CatalogImporter::parseChunk(pieces[i], fmt, chunks[i]);
+                }));
+            }
+            for(auto& f : parsed)
+                f.get();
+
+            ImportStats stats;
+            for(auto& ch : chunks){
+                AddBooks(ch.rows);
+                stats.rows += ch.rows.size();
+                stats.badRows += ch.badRows;
+            }
+            stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            return stats;
+        }
+
+        /*
+            Copies the catalog columns and the member fields under the shared
+            catalog lock (borrow/return keep running; only add/remove wait),
+            then serializes without holding anything. The ledger is copied with
+            every member stripe held at once, taken in index order, so the loans
+            are one consistent cut; borrow/return only pause for that copy.
+            Availability is derived from the copied loans so books and loans in
+            the file always agree. Members still only in the loaded snapshot
+            are copied from it as they are, without being materialized.
+        */
+        void SaveSnapshot(const string& path) const {
+            SnapshotWriter w;
+            vector<BookRow>     rows;
+            vector<uint8_t>     live;
+            vector<LoanInfo>    loans;
+            struct MemberRow{
+                string_view name, email, phone;     // Into `owned` or the loaded snapshot
+                int         maxBorrow{0};
+                bool        live{false};
+            };
+            vector<MemberRow>   mems;
+            deque<string>       owned;              // Deque: growing it never moves the strings
+            shared_ptr<LibrarySnapshot> loaded;
+            {
+                shared_lock<shared_mutex> lk(catalogLock);
+                rows.resize(store.size());
+                live.resize(store.size());
+                for(int id = 1; id < store.size(); id++){
+                    rows[id] = {store.title(id), store.author(id), store.publisher(id), store.isbn(id), store.year(id)};
+                    live[id] = store.contains(id);
+                }
+                loaded = snapshot;
+                mems.resize(members.size());
+                for(int id = 1; id < (int)members.size(); id++){
+                    if(!members[id].live.load(memory_order_acquire))
+                        continue;
+                    MemberRow& r = mems[id];
+                    r.live = true;
+                    if(Member *m = members[id].obj.load(memory_order_acquire)){
+                        r.name = owned.emplace_back(m->getName());
+                        r.email = owned.emplace_back(m->getEmail());
+                        r.phone = owned.emplace_back(m->getPhone());
+                        r.maxBorrow = m->getBorrow();
+                    } else {
+                        const SnapMember& sm = loaded->member(id);
+                        r = {loaded->str(sm.name), loaded->str(sm.email), loaded->str(sm.phone), sm.maxBorrow, true};
+                    }
+                }
+                array<unique_lock<mutex>, STRIPES> all;
+                for(int s = 0; s < STRIPES; s++)
+                    all[s] = unique_lock<mutex>(memberStripes[s].m);
+                for(int s = 0; s < STRIPES; s++)
+                    ledger.forEachInShard(s, [&](const LoanInfo& l){ loans.push_back(l); });
+            }
+
+            vector<uint8_t> onLoan(rows.size());
+            for(auto& l : loans){
+                onLoan[l.bookId] = 1;
+                w.loans.push_back({l.bookId, l.memberId, SnapshotWriter::nanos(l.borrowedAt), SnapshotWriter::nanos(l.dueAt)});
+            }
+
+            w.books.resize(rows.size());
+            for(size_t id = 1; id < rows.size(); id++){
+                SnapBook& b = w.books[id];
+                b.title = w.put(rows[id].title);
+                b.author = w.putShared(rows[id].author);
+                b.publisher = w.putShared(rows[id].publisher);
+                b.isbn = w.put(rows[id].isbn);
+                b.year = rows[id].year;
+                b.available = !onLoan[id];
+                b.live = live[id];
+            }
+
+            w.members.resize(max<size_t>(1, mems.size()));
+            for(size_t id = 1; id < mems.size(); id++){
+                if(!mems[id].live)
+                    continue;
+                SnapMember& m = w.members[id];
+                m.name = w.put(mems[id].name);
+                m.email = w.put(mems[id].email);
+                m.phone = w.put(mems[id].phone);
+                m.maxBorrow = mems[id].maxBorrow;
+                m.live = 1;
+            }
+
+            w.write(path);
+        }
+
+        future<void> SaveSnapshotAsync(const string& path) const {
+            return async(launch::async, [this, path]{ SaveSnapshot(path); });
+        }
+
+        /*
+            Restores an empty Library from a snapshot. Book strings stay in the
+            mapping and are only referenced; members are materialized lazily by
+            findMember(). Only the indexes and the ledger are rebuilt eagerly.
+        */
+        void LoadSnapshot(const string& path){
+            auto snap = make_shared<LibrarySnapshot>(path);
+
+            unique_lock<shared_mutex> lk(catalogLock);
+            if(store.size() > 1 || members.size() > 1)
+                throw logic_error("LoadSnapshot needs an empty Library");
+
+            // Borrow/return don't take catalogLock; holding every member stripe keeps them out until the ledger is in
+            array<unique_lock<mutex>, STRIPES> all;
+            for(int s = 0; s < STRIPES; s++)
+                all[s] = unique_lock<mutex>(memberStripes[s].m);
+
+            snapshot = snap;
+            ledger.reserveBooks(snap->bookCount());
+            for(size_t id = 1; id < snap->bookCount(); id++){
+                const SnapBook& b = snap->book(id);
+                store.adopt(snap->str(b.title), snap->str(b.author), snap->str(b.publisher), snap->str(b.isbn), b.year, b.available, b.live);
+                if(b.live)
+                    index.add(id, store.isbn(id), store.author(id), b.year, b.available);
+            }
+            store.commit();
+
+            members.resize(snap->memberCount());
+            for(size_t id = 1; id < snap->memberCount(); id++)
+                members[id].live.store(snap->member(id).live, memory_order_release);
+            seqMember = max<int>(1, snap->memberCount());
+
+            // Every loan must name a live member and a live book that is out, and no book twice
+            vector<uint8_t> onLoan(store.size());
+            for(size_t i = 0; i < snap->loanCount(); i++){
+                const SnapLoan& l = snap->loan(i);
+                if(!store.contains(l.bookId) || store.available(l.bookId) || onLoan[l.bookId]
+                   || l.memberId <= 0 || l.memberId >= (int)members.size() || !members[l.memberId].live.load())
+                    throw runtime_error("corrupt snapshot loan");
+                onLoan[l.bookId] = 1;
+                ledger.open(l.memberId, l.bookId,
+                            chrono::system_clock::time_point(chrono::duration_cast<chrono::system_clock::duration>(chrono::nanoseconds(l.borrowedAt))),
+                            chrono::system_clock::time_point(chrono::duration_cast<chrono::system_clock::duration>(chrono::nanoseconds(l.dueAt))));
+            }
+        }
+
+        // Materializes a Book for callers that still want the object API; nullopt if there is no such book
+        optional<Book> GetBook(int id) const {
+            shared_lock<shared_mutex> lk(catalogLock);
+            if(!store.contains(id))
+                return nullopt;
+            lock_guard<mutex> bk(bookLock(id));
+            return Book(id, string(store.title(id)), string(store.author(id)), string(store.publisher(id)),
+                        string(store.isbn(id)), store.year(id), store.available(id));
         }
 
         int AddMember(string name, string email, string phone){
+            unique_lock<shared_mutex> lk(catalogLock);
             int id = seqMember++;
-            Member *m = new Member(id, name, email, phone, 5);
-            members[id] = m;
+            members.resize(id + 1);
+            members[id].obj.store(new Member(id, name, email, phone, 5), memory_order_release);
+            members[id].live.store(true, memory_order_release);
             return id;
         }
 
-        void RemoveMember(int id){
-            if(members.find(id) == members.end()){
-                cout << "No Member Exists\n";
-                return;
+        // Refused while the member still has books out or is queued for / holding one
+        bool RemoveMember(int id){
+            unique_lock<shared_mutex> lk(catalogLock);
+            if(!memberInRange(id)){
+                if(log) *log << "No Member Exists\n";
+                return false;
+            }
+            lock_guard<mutex> mb(memberLock(id));
+            if(!findMember(id)){
+                if(log) *log << "No Member Exists\n";
+                return false;
+            }
+
+            bool busy = false;
+            ledger.forEachOfMember(id, [&](const LoanInfo&){ busy = true; });
+            for(int s = 0; s < STRIPES; s++){
+                lock_guard<mutex> bk(bookStripes[s].m);
+                const HoldShard& hs = holds[s];
+                for(auto& q : hs.queue)
+                    busy |= find(q.second.begin(), q.second.end(), id) != q.second.end();
+                for(auto& h : hs.heldFor)
+                    busy |= h.second == id;
+            }
+            if(busy){
+                if(log) *log << "Member still has loans or holds\n";
+                return false;
             }
 
-            members.erase(members.find(id));
-            cout << "Member Removed \n";
+            members[id].live.store(false, memory_order_release);
+            delete members[id].obj.exchange(nullptr);
+            if(log) *log << "Member Removed \n";
+            return true;
         }
 
-        void BorrowBook(int mid, int bid){
-            if(books.find(bid) == books.end() || books[bid]->getAvailable() == false){
-                cout << "Book Not Available\n";
-                return;
+        bool BorrowBook(int mid, int bid, chrono::system_clock::time_point at = chrono::system_clock::now()){
+            if(!store.inRange(bid) || !memberInRange(mid)){
+                if(log) *log << "Book Not Available\n";
+                return false;
             }
 
-            books[bid]->setBorrowed();
-            members[mid]->borrowBook(bid);
+            scoped_lock sl(bookLock(bid), memberLock(mid));
+            Member *mem = findMember(mid);
+            if(!mem || !store.contains(bid)){
+                if(log) *log << "Book Not Available\n";
+                return false;
+            }
+            if(store.available(bid) == false){
+                auto& held = holds[bid % STRIPES].heldFor;
+                auto it = held.find(bid);
+                if(it == held.end() || it->second != mid){
+                    if(log) *log << "Book Not Available\n";
+                    return false;
+                }
+                held.erase(it);
+            }
+
+            store.setAvailable(bid, false);
+            index.setAvailable(bid, false);
+            ledger.open(mid, bid, at, at + loanPeriod);
 
-            cout << books[bid]->getTitle() << " Borrowed by " << members[mid]->getName() << "\n";
+            if(log) *log << store.title(bid) << " Borrowed by " << mem->getName() << "\n";
+            return true;
         }
 
-        void ReturnBook(int mid, int bid){
-            if(books.find(bid) == books.end() || books[bid]->getAvailable() == true){
-                cout << "Book does not exist or already returned\n";
-                return;
+        bool ReturnBook(int mid, int bid){
+            if(!store.inRange(bid) || !memberInRange(mid)){
+                if(log) *log << "Book does not exist or already returned\n";
+                return false;
             }
 
-            books[bid]->setReturned();
-            members[mid]->returnBook(bid);
+            scoped_lock sl(bookLock(bid), memberLock(mid));
+            Member *mem = findMember(mid);
+            if(!mem || !store.contains(bid) || store.available(bid) == true || !ledger.close(mid, bid)){
+                if(log) *log << "Book does not exist or already returned\n";
+                return false;
+            }
+
+            if(log) *log << store.title(bid) << " Returned by " << mem->getName() << endl;
 
-            cout << books[bid]->getTitle() << " Returned by " << members[mid]->getName() << endl;
+            // Hand the book to the first member still waiting; it stays unavailable to everyone else
+            HoldShard& hs = holds[bid % STRIPES];
+            auto q = hs.queue.find(bid);
+            while(q != hs.queue.end() && !q->second.empty()){
+                int next = q->second.front();
+                q->second.pop_front();
+                if(!findMember(next))
+                    continue;
+
+                hs.heldFor[bid] = next;
+                if(q->second.empty())
+                    hs.queue.erase(q);
+                notifications.publish({bid, next});
+                return true;
+            }
+            if(q != hs.queue.end())
+                hs.queue.erase(q);
+
+            store.setAvailable(bid, true);
+            index.setAvailable(bid, true);
+            return true;
+        }
+
+        // Queues `mid` for a book that is currently out; false if it could be borrowed right away
+        bool PlaceHold(int mid, int bid){
+            if(!store.inRange(bid) || !memberInRange(mid))
+                return false;
+
+            scoped_lock sl(bookLock(bid), memberLock(mid));
+            if(!findMember(mid) || !store.contains(bid) || store.available(bid))
+                return false;
+
+            auto& q = holds[bid % STRIPES].queue[bid];
+            if(find(q.begin(), q.end(), mid) != q.end())
+                return false;
+            q.push_back(mid);
+            return true;
+        }
+
+        bool CancelHold(int mid, int bid){
+            if(!store.inRange(bid) || !memberInRange(mid))
+                return false;
+
+            scoped_lock sl(bookLock(bid), memberLock(mid));
+            if(!findMember(mid) || !store.contains(bid))
+                return false;
+            HoldShard& hs = holds[bid % STRIPES];
+
+            auto q = hs.queue.find(bid);
+            if(q != hs.queue.end()){
+                auto it = find(q->second.begin(), q->second.end(), mid);
+                if(it != q->second.end()){
+                    q->second.erase(it);
+                    if(q->second.empty())
+                        hs.queue.erase(q);
+                    return true;
+                }
+            }
+
+            // Giving up a book already handed over passes it down the queue
+            auto held = hs.heldFor.find(bid);
+            if(held == hs.heldFor.end() || held->second != mid)
+                return false;
+            hs.heldFor.erase(held);
+            while(q != hs.queue.end() && !q->second.empty()){
+                int next = q->second.front();
+                q->second.pop_front();
+                if(findMember(next)){
+                    hs.heldFor[bid] = next;
+                    if(q->second.empty())
+                        hs.queue.erase(q);
+                    notifications.publish({bid, next});
+                    return true;
+                }
+            }
+            if(q != hs.queue.end())
+                hs.queue.erase(q);
+            store.setAvailable(bid, true);
+            index.setAvailable(bid, true);
+            return true;
+        }
+
+        AvailabilityPublisher& Notifications() { return notifications; }
+
+        const BookStore& Catalog() const { return store; }
+
+        void ShowCatalog(ostream& out = cout) const {
+            shared_lock<shared_mutex> lk(catalogLock);
+            for(int id = 1; id < store.size(); id++)
+                if(store.contains(id))
+                    out << id << " | " << store.title(id) << " | " << store.author(id) << " | " << store.year(id) << "\n";
+        }
+
+        vector<int> FindBooks(const BookQuery& q) const {
+            shared_lock<shared_mutex> lk(catalogLock);
+            return index.query(q);
+        }
+
+        int CountLoans() const {
+            shared_lock<shared_mutex> lk(catalogLock);
+            int cnt = 0;
+            for(int s = 0; s < STRIPES; s++){
+                lock_guard<mutex> ml(memberStripes[s].m);
+                cnt += ledger.countInShard(s);
+            }
+            return cnt;
+        }
+
+        vector<LoanInfo> LoansOf(int mid) const {
+            shared_lock<shared_mutex> lk(catalogLock);
+            lock_guard<mutex> ml(memberLock(mid));
+            vector<LoanInfo> res;
+            ledger.forEachOfMember(mid, [&](const LoanInfo& l){ res.push_back(l); });
+            return res;
+        }
+
+        vector<LoanInfo> OverdueLoans(chrono::system_clock::time_point now = chrono::system_clock::now()) const {
+            shared_lock<shared_mutex> lk(catalogLock);
+            vector<LoanInfo> res;
+            for(int s = 0; s < STRIPES; s++){
+                lock_guard<mutex> ml(memberStripes[s].m);
+                ledger.overdueInShard(s, now, res);
+            }
+            return res;
         }
 
         void ShowLoans(){
-            for(auto x : members){
-                auto mem = x.second;
-                for(auto y : mem->getLoans()){
-                    Loan *ll = y;
-                    int bid = ll->bookId;
-                    int mid = x.first;
-
-                    cout << books[bid]->getTitle() << " owned by " << members[mid]->getName() << endl;
+            shared_lock<shared_mutex> lk(catalogLock);
+            for(int s = 0; s < STRIPES; s++){
+                lock_guard<mutex> ml(memberStripes[s].m);
+                ledger.forEachInShard(s, [&](const LoanInfo& l){
+                    Member *m = findMember(l.memberId);
+                    cout << store.title(l.bookId) << " owned by " << (m ? m->getName() : "member #" + to_string(l.memberId)) << endl;
+                });
+            }
+        }
+};
+
+/*
+    Stress Test:
+        Every thread borrows & returns random books for random members. At the
+        end every successful borrow must have been matched by a return, so all
+        books are available again and no loans remain.
+*/
+void StressTest(int threads, int opsPerThread){
+    Library lib;
+    lib.SetLog(nullptr);
+
+    const int nBooks = 256, nMembers = 64;
+    vector<int> bookIds, memberIds;
+    for(int i = 0; i < nBooks; i++)
+        bookIds.push_back(lib.AddBook("Title " + to_string(i), "Author " + to_string(i % 16), "Pub", "isbn-" + to_string(i), 1900 + i % 100));
+    for(int i = 0; i < nMembers; i++)
+        memberIds.push_back(lib.AddMember("M" + to_string(i), "", ""));
+
+    // Worker threads can't throw across join(); they count what went wrong instead
+    atomic<long> borrows{0}, returns{0}, failures{0};
+    vector<thread> pool;
+    for(int t = 0; t < threads; t++){
+        pool.emplace_back([&, t]{
+            mt19937 rng(t + 1);
+            for(int i = 0; i < opsPerThread; i++){
+                int mid = memberIds[rng() % nMembers];
+                int bid = bookIds[rng() % nBooks];
+                if(lib.BorrowBook(mid, bid)){
+                    borrows++;
+                    if(!lib.ReturnBook(mid, bid)){
+                        failures++;
+                        continue;
+                    }
+                    returns++;
                 }
+                if(i % 64 == 0)
+                    lib.FindBooks(BookQuery().available());
             }
+        });
+    }
+    for(auto& th : pool)
+        th.join();
+
+    bool ok = failures == 0
+           && borrows == returns
+           && lib.CountLoans() == 0
+           && (int)lib.FindBooks(BookQuery().available()).size() == nBooks;
+
+    cout << "Stress test (" << threads << " threads): " << borrows << " borrows, " << failures << " failed returns, " << (ok ? "PASSED" : "FAILED") << "\n";
+    if(!ok)
+        exit(1);
+}
+
+// Borrow+return pairs per second as the number of terminals grows
+void ThroughputBenchmark(int opsPerThread){
+    for(int threads = 1; threads <= (int)max(4u, thread::hardware_concurrency()); threads *= 2){
+        Library lib;
+        lib.SetLog(nullptr);
+
+        const int nBooks = 4096;
+        for(int i = 0; i < nBooks; i++)
+            lib.AddBook("Title", "Author", "Pub", "isbn-" + to_string(i), 2000);
+        for(int i = 0; i < threads; i++)
+            lib.AddMember("M", "", "");
+
+        auto start = chrono::steady_clock::now();
+        vector<thread> pool;
+        for(int t = 0; t < threads; t++){
+            pool.emplace_back([&, t]{
+                int mid = t + 1;
+                for(int i = 0; i < opsPerThread; i++){
+                    int bid = 1 + (t * 7919 + i) % nBooks;
+                    if(lib.BorrowBook(mid, bid))
+                        lib.ReturnBook(mid, bid);
+                }
+            });
+        }
+        for(auto& th : pool)
+            th.join();
+
+        double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << threads << " threads: " << (long)(threads * opsPerThread / secs) << " borrow/return pairs per sec\n";
+    }
+}
+
+void ImportBenchmark(int nRows){
+    auto dir = filesystem::temp_directory_path();
+    string csvPath = (dir / "library_import.csv").string();
+    string jsonPath = (dir / "library_import.jsonl").string();
+    {
+        ofstream csv(csvPath), json(jsonPath);
+        csv << "title,author,publisher,isbn,year\n";
+        for(int i = 0; i < nRows; i++){
+            csv << "\"Title, Vol " << i << "\",Author " << i % 5000 << ",Publisher " << i % 100 << ",isbn-" << i << "," << 1900 + i % 120 << "\n";
+            json << "{\"title\": \"Title " << i << "\", \"author\": \"Author " << i % 5000 << "\", \"publisher\": \"Publisher "
+                 << i % 100 << "\", \"isbn\": \"isbn-" << i << "\", \"year\": " << 1900 + i % 120 << "}\n";
+        }
+    }
+
+    for(auto& path : {csvPath, jsonPath}){
+        Library lib;
+        lib.SetLog(nullptr);
+        ImportStats st = lib.ImportBooks(path);
+        cout << path.substr(path.rfind('.')) << ": " << st.rows << " rows (" << st.badRows << " bad) in "
+             << st.seconds * 1000 << " ms, " << (long)st.rowsPerSec() << " rows/sec\n";
+        filesystem::remove(path);
+    }
+}
+
+class HoldPrinter : public AvailabilityObserver{
+    public:
+        void update(const vector<AvailableEvent>& batch) override {
+            for(auto& e : batch)
+                cout << "Book #" << e.bookId << " is ready for member #" << e.memberId << endl;
         }
 };
 
+class BatchCounter : public AvailabilityObserver{
+    public:
+        atomic<long> batches{0}, events{0};
+        void update(const vector<AvailableEvent>& batch) override {
+            batches++;
+            events += batch.size();
+        }
+};
+
+// Many returns of books with waiting members should arrive as a few large batches
+void HoldStormBenchmark(int nBooks){
+    Library lib;
+    lib.SetLog(nullptr);
+    BatchCounter counter;
+    lib.Notifications().addObserver(&counter);
+
+    for(int i = 0; i < nBooks; i++)
+        lib.AddBook("Title", "Author", "Pub", "isbn-" + to_string(i), 2000);
+    int reader = lib.AddMember("Reader", "", ""), waiter = lib.AddMember("Waiter", "", "");
+    for(int bid = 1; bid <= nBooks; bid++){
+        lib.BorrowBook(reader, bid);
+        lib.PlaceHold(waiter, bid);
+    }
+
+    for(int bid = 1; bid <= nBooks; bid++)
+        lib.ReturnBook(reader, bid);
+    lib.Notifications().flush();
+
+    cout << nBooks << " returns with holds -> " << counter.events << " events in " << counter.batches << " batches\n";
+    lib.Notifications().rmvObserver(&counter);
+}
+
+/*
+    Snapshot round trip: save in the background while terminals keep
+    borrowing & returning, then restore into a fresh Library and check that
+    every book on loan is unavailable and in exactly one loan.
+*/
+void SnapshotBenchmark(int nBooks){
+    string path = (filesystem::temp_directory_path() / "library.snap").string();
+
+    {
+        Library lib;
+        lib.SetLog(nullptr);
+        vector<string> isbns(nBooks);
+        vector<BookRow> rows(nBooks);
+        for(int i = 0; i < nBooks; i++){
+            isbns[i] = "isbn-" + to_string(i);
+            rows[i] = {"Title", "Author", "Publisher", isbns[i], 1900 + i % 120};
+        }
+        lib.AddBooks(rows);
+        for(int i = 0; i < 1000; i++)
+            lib.AddMember("Member " + to_string(i), "m" + to_string(i) + "@example.com", "555");
+        for(int bid = 1; bid <= nBooks; bid += 10)
+            lib.BorrowBook(1 + bid % 1000, bid);
+
+        // Terminals keep passing books between two members in different ledger
+        // shards, so a save that copied the shards one at a time could see such
+        // a book twice or not at all
+        atomic<bool> done{false};
+        atomic<long> ops{0};
+        vector<thread> traffic;
+        for(int t = 0; t < 4; t++){
+            traffic.emplace_back([&, t]{
+                int a = 1 + t, b = 1 + t + LoanLedger::SHARDS / 2;
+                vector<int> owner(16, a);
+                for(int k = 0; k < 16; k++)
+                    lib.BorrowBook(a, 2 + 10 * (t * 16 + k));
+                for(int i = 0; !done; i++){
+                    int k = i % 16, bid = 2 + 10 * (t * 16 + k);
+                    int next = owner[k] == a ? b : a;
+                    if(lib.ReturnBook(owner[k], bid) && lib.BorrowBook(next, bid)){
+                        owner[k] = next;
+                        ops++;
+                    }
+                }
+            });
+        }
+
+        auto start = chrono::steady_clock::now();
+        lib.SaveSnapshotAsync(path).get();
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        done = true;
+        for(auto& th : traffic)
+            th.join();
+        cout << "Saved " << nBooks << " books in " << ms << " ms (" << ops << " borrow/returns ran meanwhile), "
+             << filesystem::file_size(path) / 1024 << " KB\n";
+    }
+
+    Library restored;
+    restored.SetLog(nullptr);
+    auto start = chrono::steady_clock::now();
+    try {
+        restored.LoadSnapshot(path);
+    } catch(const runtime_error& e){
+        cout << "Round trip under load: FAILED (" << e.what() << ")\n";
+        exit(1);
+    }
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    auto loans = restored.LoansOf(42);
+    cout << "Loaded in " << ms << " ms: " << restored.CountLoans() << " loans, "
+         << restored.FindBooks(BookQuery().available()).size() << " available, member 42 holds " << loans.size() << "\n";
+    filesystem::remove(path);
+
+    vector<int> loansOf(restored.Catalog().size());
+    for(int mid = 1; mid <= 1000; mid++)
+        for(const LoanInfo& l : restored.LoansOf(mid))
+            loansOf[l.bookId]++;
+    bool ok = true;
+    for(int bid = 1; bid < restored.Catalog().size(); bid++)
+        ok &= restored.Catalog().available(bid) ? loansOf[bid] == 0 : loansOf[bid] == 1;
+    cout << "Round trip under load: " << (ok ? "PASSED" : "FAILED") << "\n";
+    if(!ok)
+        exit(1);
+}
+
+// Nightly overdue job: one loan per book, due dates spread over a year
+void OverdueBenchmark(int nBooks){
+    Library lib;
+    lib.SetLog(nullptr);
+
+    const int nMembers = nBooks / 4;
+    for(int i = 0; i < nBooks; i++)
+        lib.AddBook("Title", "Author", "Pub", "isbn-" + to_string(i), 2000);
+    for(int i = 0; i < nMembers; i++)
+        lib.AddMember("M", "", "");
+
+    auto epoch = chrono::system_clock::now();
+    for(int bid = 1; bid <= nBooks; bid++)
+        lib.BorrowBook(1 + bid % nMembers, bid, epoch + chrono::hours(24 * (bid % 365)));
+
+    auto start = chrono::steady_clock::now();
+    auto overdue = lib.OverdueLoans(epoch + chrono::hours(24 * 30));     // Loans borrowed in the first ~2 weeks
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    cout << nBooks << " loans: " << overdue.size() << " overdue found in " << ms << " ms\n";
+}
+
 int main() {
     Library lib;
 
@@ -237,5 +1949,45 @@ int main() {
     cout << "\n--- Showing Loans After Return ---\n";
     lib.ShowLoans();
 
+    lib.AddBook("The Lord of the Rings", "J.R.R. Tolkien", "Allen & Unwin", "978-0544003415", 1954);
+    lib.AddBook("The Silmarillion", "J.R.R. Tolkien", "Allen & Unwin", "978-0544338012", 1977);
+
+    cout << "\n--- Tolkien, 1930-1960, Available ---\n";
+    for(int id : lib.FindBooks(BookQuery().byAuthor("J.R.R. Tolkien").publishedBetween(1930, 1960).available()))
+        cout << "Book #" << id << "\n";
+
+    cout << "\n--- Holds ---\n";
+    int carolId = lib.AddMember("Carol", "carol@example.com", "5555555555");
+    HoldPrinter printer;
+    lib.Notifications().addObserver(&printer);
+    lib.PlaceHold(aliceId, book2);
+    lib.PlaceHold(carolId, book2);
+    lib.ReturnBook(bobId, book2);
+    lib.CancelHold(aliceId, book2);         // Passed on to Carol in the same window; both hear about it
+    lib.Notifications().flush();
+    lib.BorrowBook(aliceId, book2);
+    lib.BorrowBook(carolId, book2);
+    lib.Notifications().rmvObserver(&printer);
+
+    cout << "\n--- Catalog ---\n";
+    lib.ShowCatalog();
+    cout << "Catalog memory: " << lib.Catalog().bytes() << " bytes\n";
+
+    cout << "\n--- Concurrency ---\n";
+    StressTest(8, 20000);
+    ThroughputBenchmark(200000);
+
+    cout << "\n--- Overdue Loans ---\n";
+    OverdueBenchmark(200000);
+
+    cout << "\n--- Bulk Import ---\n";
+    ImportBenchmark(200000);
+
+    cout << "\n--- Hold Storm ---\n";
+    HoldStormBenchmark(100000);
+
+    cout << "\n--- Snapshot ---\n";
+    SnapshotBenchmark(500000);
+
     return 0;
 }
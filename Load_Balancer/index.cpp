@@ -1,8 +1,2661 @@
 // https://www.lldcoding.com/design-lld-load-balancer-machine-coding
 #include <bits/stdc++.h>
 
+// POSIX sockets for health probes & local stand-in backends (Linux)
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
 using namespace std;
 
+/*
+    Required Flows:
+        - Register / remove backends (with a weight)
+        - Pick a backend for every request, using a pluggable strategy
+        - Track in-flight requests per backend so strategies can use load
+
+    Components:
+        - Backend
+            - Address, weight & live counters
+        - BackendSet
+            - Immutable snapshot of the current backends + the strategy & its
+              precomputed state (e.g. the weighted schedule)
+        - SelectionStrategy (Strategy Pattern, see Patterns/Strategy.cpp)
+            - RoundRobin, WeightedRoundRobin, LeastConnections, PowerOfTwoChoices
+        - LoadBalancer
+            - Publishes BackendSets RCU-style & hands out Leases
+        - HealthChecker
+            - Active probes + passive outlier ejection, off the hot path
+        - TcpProxy
+            - L4 data path: epoll loop per core, splice() between sockets
+        - ConnectionPool
+            - Idle keepalive upstream connections, per backend & per thread
+
+    Hot path:
+        Picking reads the current BackendSet through one atomic pointer and
+        never takes a lock. Membership changes build a new set, swap the
+        pointer and free the old set only once no reader can still see it.
+*/
+
+/*
+    Tiny RCU:
+        - Every reading thread owns a cache-line sized slot and writes the
+          global epoch into it while it reads, 0 when it is done.
+        - A writer swaps the pointer, bumps the epoch, then waits until every
+          slot is idle or has moved past the new epoch. After that nobody can
+          hold the old pointer and it can be freed.
+*/
+class RcuDomain{
+        static constexpr int MAX_READERS = 512;
+
+        struct alignas(64) Slot{
+            atomic<uint64_t>    epoch{0};
+            atomic<bool>        used{false};
+        };
+
+        struct Registration{
+            RcuDomain   *domain{nullptr};
+            int         slot{-1}, depth{0};
+            ~Registration(){
+                if(domain)
+                    domain->slots[slot].used.store(false, memory_order_release);
+            }
+        };
+
+        Slot                slots[MAX_READERS];
+        atomic<uint64_t>    globalEpoch{1};
+
+        Registration& self(){
+            static thread_local Registration reg;
+            if(reg.slot == -1){
+                for(int i = 0; i < MAX_READERS; i++){
+                    bool expected = false;
+                    if(slots[i].used.compare_exchange_strong(expected, true)){
+                        reg.domain = this;
+                        reg.slot = i;
+                        return reg;
+                    }
+                }
+                throw runtime_error("too many RCU reader threads");
+            }
+            return reg;
+        }
+
+    public:
+        void readLock(){
+            Registration& r = self();
+            if(r.depth++ == 0)
+                slots[r.slot].epoch.store(globalEpoch.load(memory_order_relaxed), memory_order_seq_cst);
+        }
+
+        void readUnlock(){
+            Registration& r = self();
+            if(--r.depth == 0)
+                slots[r.slot].epoch.store(0, memory_order_release);
+        }
+
+        // Returns once every reader that might have seen the old pointer is done
+        void synchronize(){
+            uint64_t target = globalEpoch.fetch_add(1, memory_order_seq_cst) + 1;
+            for(auto& s : slots){
+                if(!s.used.load(memory_order_acquire))
+                    continue;
+                uint64_t e;
+                while((e = s.epoch.load(memory_order_acquire)) != 0 && e < target)
+                    this_thread::yield();
+            }
+        }
+};
+
+RcuDomain rcu;
+
+class RcuReadGuard{
+    public:
+        RcuReadGuard()  { rcu.readLock(); }
+        ~RcuReadGuard() { rcu.readUnlock(); }
+        RcuReadGuard(const RcuReadGuard&) = delete;
+        RcuReadGuard& operator=(const RcuReadGuard&) = delete;
+};
+
+// Per-thread xorshift so random choices never share state between threads
+inline uint64_t threadRandom(){
+    static thread_local uint64_t x = 0x9E3779B97F4A7C15ULL ^ (uint64_t)hash<thread::id>()(this_thread::get_id());
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return x;
+}
+
+/*
+    Monotonic time in nanoseconds. A pointer so the simulation can run every
+    latency-aware piece on virtual time.
+*/
+int64_t steadyNowNs(){
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t (*clockNs)() = steadyNowNs;
+
+/*
+    Peak EWMA latency:
+        - A sample above the current value replaces it immediately (the peak),
+          so a backend that turns slow is penalized at once.
+        - Otherwise the value moves toward the sample with weight
+          exp(-elapsed / tau), i.e. by how long it has been since the last sample.
+        - Readers decay the value toward zero the same way, so a backend that
+          was penalized & then left idle gets probed again eventually.
+    Both fields are updated without locks. Two racing samples may interleave
+    their stamps; for a routing heuristic that is fine.
+*/
+class PeakEwma{
+        atomic<double>  value{0};       // Nanoseconds
+        atomic<int64_t> stamp{0};
+        double          tauNs;
+
+    public:
+        explicit PeakEwma(double _tauNs = 10e9) : tauNs(_tauNs) {}
+
+        void observe(double rttNs, int64_t now){
+            int64_t last = stamp.exchange(now, memory_order_relaxed);
+            double w = exp(-max<int64_t>(0, now - last) / tauNs);
+            double cur = value.load(memory_order_relaxed), next;
+            do {
+                next = rttNs > cur ? rttNs : cur * w + rttNs * (1 - w);
+            } while(!value.compare_exchange_weak(cur, next, memory_order_relaxed));
+        }
+
+        double get(int64_t now) const {
+            double v = value.load(memory_order_relaxed);
+            int64_t elapsed = now - stamp.load(memory_order_relaxed);
+            return elapsed > 0 ? v * exp(-elapsed / tauNs) : v;
+        }
+};
+
+class Backend{
+    public:
+        const int       id;
+        const string    address;
+        const int       weight;
+
+        // Own cache line: bumped on every request. The outcome counters share
+        // it, so reporting success/failure costs no extra cache miss.
+        alignas(64) atomic<int>         inflight{0};
+        atomic<uint32_t>                consecutiveErrors{0};
+        atomic<uint32_t>                windowOk{0}, windowErr{0};
+
+        alignas(64) PeakEwma            latency;           // Fed by Lease::complete()
+
+        // Written by the HealthChecker, read when a new BackendSet is built
+        atomic<bool>                    healthy{true}, ejected{false};
+
+        bool routable() const { return healthy.load(memory_order_relaxed) && !ejected.load(memory_order_relaxed); }
+
+        Backend(int _id, string _address, int _weight=1) : id(_id), address(move(_address)), weight(max(1, _weight)) {}
+};
+
+class SelectionStrategy;
+
+// Whatever a strategy precomputes for one backend set
+class StrategyState{
+    public:
+        virtual ~StrategyState() = default;
+};
+
+struct BackendSet{
+    vector<Backend*>            backends;
+    const SelectionStrategy     *strategy{nullptr};
+    unique_ptr<StrategyState>   state;
+    uint64_t                    version{0};
+};
+
+/* =========================================================
+   Strategy – how a backend is picked from a set.
+   ---------------------------------------------------------
+   prepare() runs on the (rare) write path when a new set is
+   published and gets the previous state of the same strategy
+   (or nullptr) so it can update instead of rebuilding.
+   pick() runs on every request and must not block.
+   `key` is the request's routing key (0 if it has none).
+   ---------------------------------------------------------*/
+class SelectionStrategy{
+    public:
+        virtual string name() const = 0;
+        virtual unique_ptr<StrategyState> prepare(const vector<Backend*>& /*backends*/, const StrategyState * /*previous*/) const { return nullptr; }
+        virtual Backend* pick(const BackendSet& set, uint64_t key) const = 0;
+        virtual ~SelectionStrategy() = default;
+};
+
+/*
+    Round robin with a per-thread cursor: a single shared counter would be one
+    cache line bounced between every core. Each thread starts at a random
+    offset, so together they still spread evenly.
+*/
+class RoundRobin : public SelectionStrategy{
+    public:
+        string name() const override { return "round-robin"; }
+
+        Backend* pick(const BackendSet& set, uint64_t) const override {
+            static thread_local uint64_t cursor = threadRandom();
+            return set.backends[cursor++ % set.backends.size()];
+        }
+};
+
+/*
+    Smooth weighted round robin (as in nginx): the schedule is expanded once per
+    set so weights 5,1,1 give "A A B A C A A" instead of "A A A A A B C".
+*/
+class WeightedRoundRobin : public SelectionStrategy{
+        struct Schedule : StrategyState{
+            vector<uint32_t> order;
+        };
+
+    public:
+        string name() const override { return "weighted-round-robin"; }
+
+        unique_ptr<StrategyState> prepare(const vector<Backend*>& backends, const StrategyState*) const override {
+            auto sch = make_unique<Schedule>();
+            int g = 0, total = 0;
+            for(auto b : backends)
+                g = __gcd(g, b->weight);
+            for(auto b : backends)
+                total += b->weight / max(1, g);
+
+            vector<long> current(backends.size(), 0);
+            for(int step = 0; step < total; step++){
+                size_t best = 0;
+                for(size_t i = 0; i < backends.size(); i++){
+                    current[i] += backends[i]->weight / g;
+                    if(current[i] > current[best])
+                        best = i;
+                }
+                current[best] -= total;
+                sch->order.push_back(best);
+            }
+            return sch;
+        }
+
+        Backend* pick(const BackendSet& set, uint64_t) const override {
+            static thread_local uint64_t cursor = threadRandom();
+            auto& order = static_cast<const Schedule&>(*set.state).order;
+            return set.backends[order[cursor++ % order.size()]];
+        }
+};
+
+class LeastConnections : public SelectionStrategy{
+    public:
+        string name() const override { return "least-connections"; }
+
+        // Ties are broken from a random start so idle backends share the load
+        Backend* pick(const BackendSet& set, uint64_t) const override {
+            size_t n = set.backends.size(), start = threadRandom() % n;
+            Backend *best = set.backends[start];
+            int bestLoad = best->inflight.load(memory_order_relaxed);
+            for(size_t i = 1; i < n && bestLoad > 0; i++){
+                Backend *b = set.backends[(start + i) % n];
+                int load = b->inflight.load(memory_order_relaxed);
+                if(load < bestLoad){
+                    best = b;
+                    bestLoad = load;
+                }
+            }
+            return best;
+        }
+};
+
+// Two random backends, keep the less loaded one: O(1) and close to least-connections
+class PowerOfTwoChoices : public SelectionStrategy{
+    public:
+        string name() const override { return "power-of-two-choices"; }
+
+        Backend* pick(const BackendSet& set, uint64_t) const override {
+            size_t n = set.backends.size();
+            if(n == 1)
+                return set.backends[0];
+
+            uint64_t r = threadRandom();
+            size_t i = r % n, j = (r >> 32) % (n - 1);
+            if(j >= i) j++;
+
+            Backend *a = set.backends[i], *b = set.backends[j];
+            return b->inflight.load(memory_order_relaxed) < a->inflight.load(memory_order_relaxed) ? b : a;
+        }
+};
+
+/*
+    Consistent Hashing:
+        Sticky routing by key with as little remapping as possible when
+        backends come & go. All three hash the key first so sequential ids
+        spread out.
+
+        - RingHash      : every backend owns `vnodes` points on a 64-bit ring and
+                          a key goes to the next point clockwise. A bucket table
+                          over the top bits of the hash jumps straight to the
+                          right neighbourhood, so lookup is O(1) expected.
+                          Membership changes only add/drop that backend's
+                          points and merge them into the previous ring.
+        - JumpHash      : Lamping & Veach. No memory at all, O(log n) lookup;
+                          remaps minimally when backends are added or removed
+                          at the end of the list.
+        - Maglev        : a prime-sized table filled from per-backend
+                          permutations; lookup is a single array index.
+                          Rebuilds start from the previous table and only
+                          reassign the slots of departed and new backends.
+*/
+inline uint64_t mix64(uint64_t x){
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// FNV-1a, for turning string keys (user ids, session cookies, ...) into routing keys
+inline uint64_t hashKey(string_view s){
+    uint64_t h = 1469598103934665603ULL;
+    for(char c : s){
+        h ^= (uint8_t)c;
+        h *= 1099511628211ULL;
+    }
+    return mix64(h);
+}
+
+class RingHash : public SelectionStrategy{
+        struct Ring : StrategyState{
+            vector<pair<uint64_t, Backend*>>    points;         // Sorted by hash
+            vector<uint32_t>                    bucketStart;    // First point in each bucket
+            int                                 shift{64};
+        };
+
+        int vnodes;
+
+        void buildBuckets(Ring& r) const {
+            int bits = 1;
+            while(bits < 24 && (1ULL << bits) < r.points.size() * 2)
+                bits++;
+            r.shift = 64 - bits;
+            r.bucketStart.assign((1ULL << bits) + 1, 0);
+
+            size_t i = 0;
+            for(uint64_t b = 0; b <= (1ULL << bits); b++){
+                while(i < r.points.size() && (r.points[i].first >> r.shift) < b)
+                    i++;
+                r.bucketStart[b] = i;
+            }
+        }
+
+    public:
+        explicit RingHash(int _vnodes=160) : vnodes(_vnodes) {}
+
+        string name() const override { return "ring-hash"; }
+
+        unique_ptr<StrategyState> prepare(const vector<Backend*>& backends, const StrategyState *previous) const override {
+            auto ring = make_unique<Ring>();
+            unordered_set<Backend*> now(backends.begin(), backends.end()), before;
+
+            if(previous){
+                auto& prev = static_cast<const Ring&>(*previous).points;
+                ring->points.reserve(prev.size());
+                for(auto& p : prev){
+                    before.insert(p.second);
+                    if(now.count(p.second))
+                        ring->points.push_back(p);
+                }
+            }
+
+            vector<pair<uint64_t, Backend*>> added;
+            for(auto b : backends)
+                if(!before.count(b))
+                    for(int v = 0; v < vnodes; v++)
+                        added.push_back({hashKey(b->address + "#" + to_string(v)), b});
+            sort(added.begin(), added.end());
+
+            vector<pair<uint64_t, Backend*>> merged;
+            merged.reserve(ring->points.size() + added.size());
+            merge(ring->points.begin(), ring->points.end(), added.begin(), added.end(), back_inserter(merged));
+            ring->points = move(merged);
+
+            buildBuckets(*ring);
+            return ring;
+        }
+
+        Backend* pick(const BackendSet& set, uint64_t key) const override {
+            auto& r = static_cast<const Ring&>(*set.state);
+            uint64_t h = mix64(key);
+            size_t i = r.bucketStart[h >> r.shift];
+            while(i < r.points.size() && r.points[i].first < h)
+                i++;
+            return r.points[i == r.points.size() ? 0 : i].second;
+        }
+};
+
+class JumpHash : public SelectionStrategy{
+    public:
+        string name() const override { return "jump-hash"; }
+
+        static int32_t jump(uint64_t key, int32_t buckets){
+            int64_t b = -1, j = 0;
+            while(j < buckets){
+                b = j;
+                key = key * 2862933555777941757ULL + 1;
+                j = (int64_t)((b + 1) * ((double)(1LL << 31) / (double)((key >> 33) + 1)));
+            }
+            return (int32_t)b;
+        }
+
+        Backend* pick(const BackendSet& set, uint64_t key) const override {
+            return set.backends[jump(mix64(key), set.backends.size())];
+        }
+};
+
+/*
+    The first build is the usual Maglev fill: backends take turns claiming the
+    next free slot of their permutation. After that, a rebuild starts from a
+    copy of the previous table and only touches the slots that change hands:
+        - slots of departed backends are freed,
+        - a new backend walks its permutation taking free slots, or slots of
+          owners still above the fair share, until it holds size / n,
+        - slots still free are handed out by resuming the turn-taking fill
+          from each survivor's saved position (next).
+    Survivors keep every slot they are not asked to give up, so a join or a
+    leave moves about 1/n of the keys, which is the least it can move. The
+    result differs from a fresh fill of the same set, but stays within a slot
+    or two of size / n per backend. The copy itself is an O(M) memcpy; the
+    permutation walk is proportional to the slots that move.
+*/
+class Maglev : public SelectionStrategy{
+        struct Perm{
+            uint64_t offset, skip;
+            uint64_t next  = 0;      // Position reached in the permutation
+            uint64_t count = 0;      // Slots owned in `entry`
+        };
+
+        struct Table : StrategyState{
+            vector<Backend*>                entry;
+            unordered_map<Backend*, Perm>   perms;
+        };
+
+        uint64_t size;      // Prime, comfortably larger than the number of backends
+
+        uint64_t slot(const Perm& p, uint64_t j) const { return (p.offset + j * p.skip) % size; }
+
+        // Turn-taking fill of whatever slots are still empty
+        void fill(Table& t, const vector<Backend*>& backends, uint64_t freeSlots) const {
+            while(freeSlots){
+                for(size_t i = 0; i < backends.size() && freeSlots; i++){
+                    Perm& p = t.perms.at(backends[i]);
+                    uint64_t c;
+                    do {
+                        c = slot(p, p.next++);
+                    } while(t.entry[c]);
+                    t.entry[c] = backends[i];
+                    p.count++;
+                    freeSlots--;
+                }
+            }
+        }
+
+    public:
+        explicit Maglev(uint64_t _size=65537) : size(_size) {}
+
+        string name() const override { return "maglev"; }
+
+        unique_ptr<StrategyState> prepare(const vector<Backend*>& backends, const StrategyState *previous) const override {
+            auto t = make_unique<Table>();
+            const Table *prev = static_cast<const Table*>(previous);
+            if(backends.empty())
+                return t;
+
+            vector<Backend*> joined;
+            for(Backend *b : backends){
+                if(prev && prev->perms.count(b)){
+                    t->perms.emplace(b, prev->perms.at(b));
+                    continue;
+                }
+                uint64_t h = hashKey(b->address);
+                t->perms.emplace(b, Perm{h % size, mix64(h) % (size - 1) + 1});
+                joined.push_back(b);
+            }
+
+            if(!prev || prev->perms.empty()){
+                t->entry.assign(size, nullptr);
+                fill(*t, backends, size);
+                return t;
+            }
+
+            // Free the slots of backends that left
+            t->entry = prev->entry;
+            uint64_t freeSlots = 0;
+            if(t->perms.size() - joined.size() < prev->perms.size()){
+                for(Backend*& e : t->entry)
+                    if(!t->perms.count(e)){
+                        e = nullptr;
+                        freeSlots++;
+                    }
+            }
+
+            // Newcomers take their share, from free slots or from owners above it
+            uint64_t share = size / backends.size();
+            for(Backend *b : joined){
+                Perm& p = t->perms.at(b);
+                while(p.count < share){
+                    uint64_t c = slot(p, p.next++);
+                    Backend *owner = t->entry[c];
+                    if(owner){
+                        Perm& o = t->perms.at(owner);
+                        if(owner == b || o.count <= share)
+                            continue;
+                        o.count--;
+                    } else
+                        freeSlots--;
+                    t->entry[c] = b;
+                    p.count++;
+                }
+            }
+
+            fill(*t, backends, freeSlots);
+            return t;
+        }
+
+        Backend* pick(const BackendSet& set, uint64_t key) const override {
+            return static_cast<const Table&>(*set.state).entry[mix64(key) % size];
+        }
+};
+
+/*
+    Latency-aware power of two choices: of two random backends take the one
+    with the lower  peak-EWMA latency * (in-flight + 1). A slow backend keeps a
+    high cost even when it has few requests, and a fast one still sheds load
+    once requests pile up on it.
+*/
+class PeakEwmaP2C : public SelectionStrategy{
+        static double cost(Backend *b, int64_t now){
+            return (b->latency.get(now) + 1) * (b->inflight.load(memory_order_relaxed) + 1);
+        }
+
+    public:
+        string name() const override { return "peak-ewma"; }
+
+        Backend* pick(const BackendSet& set, uint64_t) const override {
+            size_t n = set.backends.size();
+            if(n == 1)
+                return set.backends[0];
+
+            uint64_t r = threadRandom();
+            size_t i = r % n, j = (r >> 32) % (n - 1);
+            if(j >= i) j++;
+
+            int64_t now = clockNs();
+            Backend *a = set.backends[i], *b = set.backends[j];
+            return cost(b, now) < cost(a, now) ? b : a;
+        }
+};
+
+/*
+    A Lease is one request routed to a backend. It holds the backend's
+    in-flight count up until it is destroyed.
+*/
+class Lease{
+        Backend *b{nullptr};
+    public:
+        Lease() = default;
+        explicit Lease(Backend *_b) : b(_b) { b->inflight.fetch_add(1, memory_order_relaxed); }
+        Lease(Lease&& o) noexcept : b(exchange(o.b, nullptr)) {}
+        Lease& operator=(Lease&& o) noexcept { release(); b = exchange(o.b, nullptr); return *this; }
+        ~Lease() { release(); }
+
+        void release(){
+            if(b)
+                exchange(b, nullptr)->inflight.fetch_sub(1, memory_order_relaxed);
+        }
+
+        // Feeds one latency sample to the backend; the lease stays held
+        void observe(int64_t latencyNs){
+            if(b)
+                b->latency.observe(latencyNs, clockNs());
+        }
+
+        // Reports how the request went and releases the backend
+        void complete(int64_t latencyNs, bool ok=true){
+            observe(latencyNs);
+            report(ok);
+        }
+
+        // Reports only the outcome, for leases whose latency was observe()d earlier (or has no meaning)
+        void report(bool ok){
+            if(b){
+                if(ok){
+                    b->windowOk.fetch_add(1, memory_order_relaxed);
+                    if(b->consecutiveErrors.load(memory_order_relaxed))
+                        b->consecutiveErrors.store(0, memory_order_relaxed);
+                } else {
+                    b->windowErr.fetch_add(1, memory_order_relaxed);
+                    b->consecutiveErrors.fetch_add(1, memory_order_relaxed);
+                }
+            }
+            release();
+        }
+
+        Backend* backend() const { return b; }
+        explicit operator bool() const { return b != nullptr; }
+};
+
+class LoadBalancer{
+        atomic<BackendSet*>             current{nullptr};
+
+        mutex                           writerLock;         // Serializes publishers, never taken by pick
+        deque<unique_ptr<Backend>>      registry;           // Backends live as long as the balancer
+        vector<Backend*>                members;
+        unique_ptr<SelectionStrategy>   strategy;
+        uint64_t                        version{0};
+        int                             seqBackend{1};
+        using Hooks = vector<pair<uint64_t, function<void(Backend*)>>>;
+        Hooks                           joinHooks, leaveHooks;
+        uint64_t                        seqHook{1};
+        shared_mutex                    hookRun;            // Shared while hooks run, exclusive to remove one
+
+        /*
+            Only healthy, non-ejected members are routed to. If none are left
+            we route to all of them (panic mode) rather than fail everything.
+        */
+        vector<Backend*> routableMembers() const {
+            vector<Backend*> res;
+            for(auto b : members)
+                if(b->routable())
+                    res.push_back(b);
+            return res.empty() ? members : res;
+        }
+
+        // Caller holds writerLock
+        // The retired strategy, if any, is owned by the unnamed parameter and destroyed on return
+        void publish(unique_ptr<SelectionStrategy> /*retiredStrategy*/ = nullptr){
+            BackendSet *old = current.load(memory_order_relaxed);
+            const StrategyState *previous = old && old->strategy == strategy.get() ? old->state.get() : nullptr;
+
+            auto next = new BackendSet();
+            next->backends = routableMembers();
+            next->strategy = strategy.get();
+            next->state = next->backends.empty() ? nullptr : strategy->prepare(next->backends, previous);
+            next->version = ++version;
+
+            current.store(next, memory_order_seq_cst);
+            rcu.synchronize();
+            delete old;
+            // The retired strategy is destroyed here, after no reader can be inside it
+        }
+
+    public:
+        explicit LoadBalancer(unique_ptr<SelectionStrategy> s) : strategy(move(s)) {
+            lock_guard<mutex> lk(writerLock);
+            publish();
+        }
+
+        ~LoadBalancer(){
+            delete current.load();
+        }
+
+        int addBackend(string address, int weight=1){
+            Backend *b;
+            Hooks hooks;
+            shared_lock<shared_mutex> running(hookRun);
+            {
+                lock_guard<mutex> lk(writerLock);
+                registry.push_back(make_unique<Backend>(seqBackend++, move(address), weight));
+                b = registry.back().get();
+                members.push_back(b);
+                publish();
+                hooks = joinHooks;
+            }
+            for(auto& h : hooks)
+                h.second(b);
+            return b->id;
+        }
+
+        /*
+            Called (outside writerLock, on the thread adding or removing) for
+            every backend added / removed from now on, so they should be quick.
+            Returns a token for removeHook(). A hook must not add or remove
+            backends or hooks itself.
+        */
+        uint64_t onBackendJoin(function<void(Backend*)> hook){
+            lock_guard<mutex> lk(writerLock);
+            joinHooks.push_back({seqHook, move(hook)});
+            return seqHook++;
+        }
+
+        uint64_t onBackendLeave(function<void(Backend*)> hook){
+            lock_guard<mutex> lk(writerLock);
+            leaveHooks.push_back({seqHook, move(hook)});
+            return seqHook++;
+        }
+
+        // Once this returns the hook is not running and never will again
+        void removeHook(uint64_t token){
+            {
+                lock_guard<mutex> lk(writerLock);
+                for(Hooks *hooks : {&joinHooks, &leaveHooks})
+                    hooks->erase(remove_if(hooks->begin(), hooks->end(), [&](auto& h){ return h.first == token; }), hooks->end());
+            }
+            unique_lock<shared_mutex> wait(hookRun);
+        }
+
+        bool removeBackend(int id){
+            Backend *b;
+            Hooks hooks;
+            shared_lock<shared_mutex> running(hookRun);
+            {
+                lock_guard<mutex> lk(writerLock);
+                auto it = find_if(members.begin(), members.end(), [&](Backend *x){ return x->id == id; });
+                if(it == members.end())
+                    return false;
+                b = *it;
+                members.erase(it);
+                publish();
+                hooks = leaveHooks;
+            }
+            for(auto& h : hooks)
+                h.second(b);
+            return true;
+        }
+
+        // Republishes if health/ejection flags changed which backends are routable
+        void refresh(){
+            lock_guard<mutex> lk(writerLock);
+            if(current.load(memory_order_relaxed)->backends != routableMembers())
+                publish();
+        }
+
+        vector<Backend*> backends(){
+            lock_guard<mutex> lk(writerLock);
+            return members;
+        }
+
+        int routableCount(){
+            RcuReadGuard g;
+            return current.load(memory_order_acquire)->backends.size();
+        }
+
+        void setStrategy(unique_ptr<SelectionStrategy> s){
+            lock_guard<mutex> lk(writerLock);
+            swap(strategy, s);
+            publish(move(s));
+        }
+
+        // Lock-free: one atomic load, the strategy's pick and one counter bump
+        Lease acquire(uint64_t key=0){
+            RcuReadGuard g;
+            BackendSet *set = current.load(memory_order_acquire);
+            if(set->backends.empty())
+                return Lease();
+            return Lease(set->strategy->pick(*set, key));
+        }
+
+        string strategyName(){
+            RcuReadGuard g;
+            return current.load(memory_order_acquire)->strategy->name();
+        }
+};
+
+/*
+    Health Checking:
+        - Active: one timer thread probes every backend on its own schedule.
+          Each probe is re-armed at interval +-jitter so probes don't line up.
+          A probe is a non-blocking connect; the thread only starts them and
+          waits on all of them at once, so a black-holed backend delays no
+          other probe, it just fails after probeTimeout.
+          `unhealthyAfter` failed probes in a row mark a backend down,
+          `healthyAfter` passes bring it back.
+        - Passive: every `outlierInterval` the same thread looks at the outcome
+          counters Lease::complete() bumps. Too many consecutive errors, or too
+          high an error rate over enough requests, ejects the backend for
+          baseEjection * 2^(times ejected before), capped at maxEjection.
+          At most maxEjectedPercent of the backends are ejected at once.
+        - Every change goes through LoadBalancer::refresh(), which publishes a
+          new BackendSet; pickers never wait for any of this.
+*/
+struct HostPort{
+    string  host;
+    int     port{0};
+};
+
+HostPort parseHostPort(const string& address){
+    auto colon = address.rfind(':');
+    if(colon == string::npos)
+        throw invalid_argument("expected host:port, got " + address);
+    return {address.substr(0, colon), stoi(address.substr(colon + 1))};
+}
+
+// Starts a non-blocking connect; the socket is returned while the handshake is still in flight
+int tcpConnectAsync(const string& address){
+    HostPort hp = parseHostPort(address);
+    sockaddr_in sa{};
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(hp.port);
+    if(inet_pton(AF_INET, hp.host.c_str(), &sa.sin_addr) != 1)
+        return -1;
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(fd < 0)
+        return -1;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+    if(connect(fd, (sockaddr*)&sa, sizeof sa) != 0 && errno != EINPROGRESS){
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Non-blocking connect with a timeout; returns the connected socket or -1
+int tcpConnect(const string& address, int timeoutMs){
+    int fd = tcpConnectAsync(address);
+    if(fd < 0)
+        return -1;
+
+    {
+        pollfd pfd{fd, POLLOUT, 0};
+        int err = 0;
+        socklen_t len = sizeof err;
+        if(poll(&pfd, 1, timeoutMs) == 1 && getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err == 0)
+            return fd;
+    }
+    close(fd);
+    return -1;
+}
+
+class HealthChecker{
+    public:
+        struct Config{
+            chrono::milliseconds    probeInterval{1000}, outlierInterval{1000};
+            double                  jitter{0.2};
+            int                     unhealthyAfter{2}, healthyAfter{2};
+            uint32_t                consecutiveErrors{5}, minRequests{20};
+            double                  maxErrorRate{0.5};
+            chrono::milliseconds    baseEjection{1000}, maxEjection{60000};
+            int                     maxEjectedPercent{50};
+            chrono::milliseconds    probeTimeout{200};  // A TCP probe not connected by then fails
+            bool                    ownThread{true};    // false: the owner calls advance() instead (simulations)
+            uint64_t                seed{0};            // Probe jitter; 0 = random
+        };
+
+    private:
+        struct Probe{
+            int     passes{0}, fails{0};
+            int     ejections{0};
+            int64_t ejectedUntil{0};
+        };
+
+        // A TCP probe whose connect is still in flight
+        struct Pending{
+            int         fd;
+            Backend     *b;
+            int64_t     deadline;
+        };
+
+        LoadBalancer                    &lb;
+        Config                          cfg;
+        function<bool(const Backend&)>  probe;          // Empty: asynchronous TCP connects
+
+        // (due time, backend) for probes; nullptr marks the outlier sweep
+        using Due = pair<int64_t, Backend*>;
+
+        unordered_map<Backend*, Probe>  state;          // Timer thread only, as are the next four
+        priority_queue<Due, vector<Due>, greater<Due>> due;
+        unordered_set<Backend*>         scheduled;
+        vector<Pending>                 inflight;
+        bool                            started{false};
+        atomic<bool>                    stopping{false};
+        int                             wakeFd{-1};
+        thread                          timer;
+        mt19937_64                      rng;
+
+        int64_t jittered(chrono::milliseconds base){
+            uniform_real_distribution<double> d(1 - cfg.jitter, 1 + cfg.jitter);
+            return (int64_t)(chrono::duration_cast<chrono::nanoseconds>(base).count() * d(rng));
+        }
+
+        // New backends get their first probe somewhere within one interval
+        int64_t firstProbe(){
+            uniform_int_distribution<int64_t> d(0, chrono::duration_cast<chrono::nanoseconds>(cfg.probeInterval).count());
+            return d(rng);
+        }
+
+        bool record(Backend *b, bool ok){
+            Probe& p = state[b];
+            if(ok){ p.passes++; p.fails = 0; }
+            else  { p.fails++; p.passes = 0; }
+
+            if(b->healthy && p.fails >= cfg.unhealthyAfter){
+                b->healthy = false;
+                return true;
+            }
+            if(!b->healthy && p.passes >= cfg.healthyAfter){
+                b->healthy = true;
+                return true;
+            }
+            return false;
+        }
+
+        bool detectOutliers(const vector<Backend*>& all, int64_t now){
+            bool changed = false;
+            int ejected = 0;
+            for(auto b : all)
+                ejected += b->ejected;
+
+            for(auto b : all){
+                Probe& p = state[b];
+                uint32_t ok = b->windowOk.exchange(0, memory_order_relaxed);
+                uint32_t err = b->windowErr.exchange(0, memory_order_relaxed);
+
+                if(b->ejected){
+                    if(now >= p.ejectedUntil){
+                        b->consecutiveErrors = 0;
+                        b->ejected = false;
+                        ejected--;
+                        changed = true;
+                    }
+                    continue;
+                }
+
+                bool outlier = b->consecutiveErrors >= cfg.consecutiveErrors
+                            || (ok + err >= cfg.minRequests && err > cfg.maxErrorRate * (ok + err));
+                if(outlier && (ejected + 1) * 100 <= cfg.maxEjectedPercent * (int)all.size()){
+                    int64_t backoff = chrono::duration_cast<chrono::nanoseconds>(cfg.baseEjection).count() << min(p.ejections, 20);
+                    p.ejectedUntil = now + min<int64_t>(backoff, chrono::duration_cast<chrono::nanoseconds>(cfg.maxEjection).count());
+                    p.ejections++;
+                    b->ejected = true;
+                    ejected++;
+                    changed = true;
+                }
+            }
+            return changed;
+        }
+
+        // Starts a non-blocking connect; the probe is re-armed once it finishes
+        bool launch(Backend *b, int64_t now){
+            int fd = tcpConnectAsync(b->address);
+            if(fd < 0){
+                due.push({now + jittered(cfg.probeInterval), b});
+                return record(b, false);
+            }
+            inflight.push_back({fd, b, now + chrono::duration_cast<chrono::nanoseconds>(cfg.probeTimeout).count()});
+            return false;
+        }
+
+        // Settles the in-flight probes that connected, failed or ran out of time
+        bool collect(int64_t now){
+            if(inflight.empty())
+                return false;
+
+            vector<pollfd> fds;
+            for(auto& p : inflight)
+                fds.push_back({p.fd, POLLOUT, 0});
+            poll(fds.data(), fds.size(), 0);
+
+            bool changed = false;
+            size_t keep = 0;
+            for(size_t i = 0; i < inflight.size(); i++){
+                Pending p = inflight[i];
+                bool ready = fds[i].revents != 0;
+                if(!ready && now < p.deadline){
+                    inflight[keep++] = p;
+                    continue;
+                }
+
+                int err = 0;
+                socklen_t len = sizeof err;
+                bool ok = ready && getsockopt(p.fd, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err == 0 && (fds[i].revents & POLLOUT);
+                close(p.fd);
+                if(scheduled.count(p.b)){
+                    changed |= record(p.b, ok);
+                    due.push({now + jittered(cfg.probeInterval), p.b});
+                }
+            }
+            inflight.resize(keep);
+            return changed;
+        }
+
+        // Sleeps on the in-flight probes and the wake-up fd until something is due
+        void run(){
+            while(!stopping){
+                int64_t next = advance(steadyNowNs());
+                vector<pollfd> fds{{wakeFd, POLLIN, 0}};
+                for(auto& p : inflight)
+                    fds.push_back({p.fd, POLLOUT, 0});
+                int64_t waitNs = max<int64_t>(0, next - steadyNowNs());
+                poll(fds.data(), fds.size(), (int)min<int64_t>((waitNs + 999999) / 1000000, INT_MAX));
+            }
+        }
+
+    public:
+        /*
+            Without `_probe` every backend is probed with a non-blocking TCP
+            connect; all probes in flight are waited on together, so a backend
+            that does not answer holds up nothing but its own result. A custom
+            probe is called inline on the timer thread and must return quickly.
+        */
+        HealthChecker(LoadBalancer& _lb, Config _cfg, function<bool(const Backend&)> _probe = nullptr)
+            : lb(_lb), cfg(_cfg), probe(move(_probe)), rng(cfg.seed ? cfg.seed : random_device{}()) {
+            if(cfg.ownThread){
+                wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+                if(wakeFd < 0)
+                    throw runtime_error("health checker cannot create an eventfd");
+                timer = thread(&HealthChecker::run, this);
+            }
+        }
+
+        ~HealthChecker(){
+            stopping = true;
+            if(timer.joinable()){
+                uint64_t one = 1;
+                (void)!write(wakeFd, &one, sizeof one);
+                timer.join();
+            }
+            for(auto& p : inflight)
+                close(p.fd);
+            if(wakeFd >= 0)
+                close(wakeFd);
+        }
+
+        /*
+            Starts every probe and runs every outlier sweep due by `now`,
+            settles the TCP probes that finished, and returns when the next
+            one is due (or the earliest in-flight probe times out). Backends that joined since the last call get
+            their first probe within one interval; those that left lose their
+            state, and their pending probe is dropped when it comes due.
+            Called by the timer thread, or by the owner when constructed
+            without one.
+        */
+        int64_t advance(int64_t now){
+            if(!started){
+                due.push({now + jittered(cfg.outlierInterval), nullptr});
+                started = true;
+            }
+            vector<Backend*> members = lb.backends();
+            for(auto b : members)
+                if(scheduled.insert(b).second)
+                    due.push({now + firstProbe(), b});
+
+            if(scheduled.size() > members.size()){
+                unordered_set<Backend*> live(members.begin(), members.end());
+                for(auto it = scheduled.begin(); it != scheduled.end(); ){
+                    if(live.count(*it)){
+                        ++it;
+                        continue;
+                    }
+                    state.erase(*it);
+                    it = scheduled.erase(it);
+                }
+            }
+
+            bool changed = collect(now);
+            while(due.top().first <= now){
+                Backend *b = due.top().second;
+                due.pop();
+                if(b){
+                    if(!scheduled.count(b))
+                        continue;
+                    if(!probe){
+                        changed |= launch(b, now);
+                        continue;
+                    }
+                    changed |= record(b, probe(*b));
+                    due.push({now + jittered(cfg.probeInterval), b});
+                } else {
+                    changed |= detectOutliers(members, now);
+                    due.push({now + jittered(cfg.outlierInterval), nullptr});
+                }
+            }
+            if(changed)
+                lb.refresh();
+
+            int64_t next = due.top().first;
+            for(auto& p : inflight)
+                next = min(next, p.deadline);
+            return next;
+        }
+};
+
+/*
+    Local stand-in backend: a loopback TCP listener on an ephemeral port whose
+    connections are handed to `handler` (by default just closed).
+*/
+class LocalServer{
+        int                 fd{-1}, port{0};
+        atomic<bool>        stopping{false};
+        thread              loop;
+        function<void(int)> handler;
+
+    public:
+        explicit LocalServer(function<void(int)> _handler = [](int c){ close(c); }, int _port=0) : handler(move(_handler)) {
+            fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            int one = 1;
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+            sockaddr_in sa{};
+            sa.sin_family = AF_INET;
+            sa.sin_port = htons(_port);
+            sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            if(bind(fd, (sockaddr*)&sa, sizeof sa) != 0 || listen(fd, 1024) != 0)
+                throw runtime_error("cannot listen on loopback");
+
+            socklen_t len = sizeof sa;
+            getsockname(fd, (sockaddr*)&sa, &len);
+            port = ntohs(sa.sin_port);
+
+            loop = thread([this]{
+                while(!stopping){
+                    pollfd pfd{fd, POLLIN, 0};
+                    if(poll(&pfd, 1, 20) == 1){
+                        int c = accept4(fd, nullptr, nullptr, SOCK_CLOEXEC);
+                        if(c >= 0)
+                            handler(c);
+                    }
+                }
+            });
+        }
+
+        ~LocalServer(){
+            stopping = true;
+            loop.join();
+            close(fd);
+        }
+
+        string address() const { return "127.0.0.1:" + to_string(port); }
+        int    getPort() const { return port; }
+};
+
+/*
+    Rate Limiter:
+        - One token bucket per client key: `burst` tokens, refilled at `rate`
+          per second. Refill is lazy: a bucket is stored as the single time at
+          which it will be full again, so its level is derived from the
+          monotonic clock when it is next touched and idle clients cost
+          nothing (no timers, no refill sweeps).
+        - Keys are spread over 256 cache-line-aligned shards, each an
+          open-addressed table of 16-byte slots behind its own mutex; a check
+          is one hash, one uncontended lock and usually one cache line.
+        - A bucket that has been full for idleTtl is indistinguishable from a
+          new one, so it is dropped. Every new bucket sweeps the next few
+          slots of its shard, and growing a table skips idle buckets, so
+          eviction is incremental, keeps pace with arrivals and costs checks
+          of known clients nothing.
+*/
+class RateLimiter{
+    public:
+        struct Config{
+            double                  rate{100}, burst{200};      // tokens per second, bucket size
+            chrono::milliseconds    idleTtl{10000};
+        };
+
+    private:
+        struct Slot{
+            uint64_t    key;
+            int64_t     full;           // When the bucket is full again; 0 = empty slot
+        };
+
+        struct alignas(64) Shard{
+            mutex           m;
+            vector<Slot>    slots = vector<Slot>(16);
+            size_t          count{0}, cursor{0};
+        };
+
+        static constexpr int SHARDS = 256;
+        static constexpr int SWEEP = 4;         // Slots examined per new bucket
+
+        const double    nsPerToken;
+        const int64_t   capacityNs, idleNs;     // Bucket size and idle TTL, in refill time
+        Shard           shards[SHARDS];
+        atomic<long>    evicted{0};
+
+        bool idle(const Slot& s, int64_t now) const { return now - s.full > idleNs; }
+
+        // Backward-shift deletion keeps linear probing free of tombstones
+        void erase(Shard& sh, size_t i){
+            size_t mask = sh.slots.size() - 1;
+            for(size_t j = (i + 1) & mask; sh.slots[j].full; j = (j + 1) & mask){
+                size_t home = mix64(sh.slots[j].key) & mask;
+                if(((j - home) & mask) >= ((j - i) & mask)){
+                    sh.slots[i] = sh.slots[j];
+                    i = j;
+                }
+            }
+            sh.slots[i].full = 0;
+            sh.count--;
+            evicted.fetch_add(1, memory_order_relaxed);
+        }
+
+        void sweep(Shard& sh, int64_t now){
+            size_t mask = sh.slots.size() - 1;
+            for(int k = 0; k < SWEEP; k++){
+                if(sh.slots[sh.cursor].full && idle(sh.slots[sh.cursor], now))
+                    erase(sh, sh.cursor);       // Something may shift in; look again next time
+                else
+                    sh.cursor = (sh.cursor + 1) & mask;
+            }
+        }
+
+        void grow(Shard& sh, int64_t now){
+            vector<Slot> old(sh.slots.size() * 2);
+            old.swap(sh.slots);
+            size_t mask = sh.slots.size() - 1;
+            sh.count = sh.cursor = 0;
+            for(auto& s : old){
+                if(!s.full)
+                    continue;
+                if(idle(s, now)){
+                    evicted.fetch_add(1, memory_order_relaxed);
+                    continue;
+                }
+                size_t i = mix64(s.key) & mask;
+                while(sh.slots[i].full)
+                    i = (i + 1) & mask;
+                sh.slots[i] = s;
+                sh.count++;
+            }
+        }
+
+    public:
+        explicit RateLimiter(Config cfg)
+            : nsPerToken(1e9 / cfg.rate), capacityNs(int64_t(cfg.burst * 1e9 / cfg.rate)),
+              idleNs(chrono::duration_cast<chrono::nanoseconds>(cfg.idleTtl).count()) {}
+
+        // Takes `cost` tokens from key's bucket if it has them
+        bool allow(uint64_t key, double cost=1){
+            return allow(key, clockNs(), cost);
+        }
+
+        // For callers that already read the clock
+        bool allow(uint64_t key, int64_t now, double cost){
+            uint64_t h = mix64(key);
+            Shard& sh = shards[h >> 56];
+            lock_guard<mutex> lk(sh.m);
+
+            size_t mask = sh.slots.size() - 1, i = h & mask;
+            while(sh.slots[i].full && sh.slots[i].key != key)
+                i = (i + 1) & mask;
+
+            if(!sh.slots[i].full){
+                sweep(sh, now);                 // Shifts slots around, so probe again after
+                if((sh.count + 1) * 2 > sh.slots.size())
+                    grow(sh, now);
+                mask = sh.slots.size() - 1;
+                for(i = h & mask; sh.slots[i].full; i = (i + 1) & mask);
+                sh.slots[i] = {key, max<int64_t>(now, 1)};
+                sh.count++;
+            }
+
+            // Full at `full`, so it holds burst - (full - now) / nsPerToken tokens now
+            Slot& s = sh.slots[i];
+            int64_t after = max(s.full, now) + int64_t(cost * nsPerToken);
+            bool ok = after - now <= capacityNs;
+            if(ok)
+                s.full = after;
+            return ok;
+        }
+
+        size_t size(){
+            size_t n = 0;
+            for(auto& sh : shards){
+                lock_guard<mutex> lk(sh.m);
+                n += sh.count;
+            }
+            return n;
+        }
+
+        long evictedCount() const { return evicted; }
+};
+
+/*
+    L4 TCP Proxy:
+        - One worker per core. Every worker has its own listening socket on the
+          same port (SO_REUSEPORT, the kernel spreads connections) and its own
+          epoll loop, so workers share nothing but the LoadBalancer.
+        - An accepted client gets a backend from the balancer and a
+          non-blocking connect; nothing waits for the handshake. The routing
+          key is a hash of the client's IP, so keyed strategies (ring, jump,
+          Maglev) keep a client host on the same backend.
+        - Bytes move socket -> pipe -> socket with splice(), so payloads never
+          enter user space. Each direction has its own pipe; a full pipe is the
+          back-pressure that stops reading until the other side drains.
+        - Edge-triggered: any event on a session pumps both directions until
+          neither can make progress. EOF is forwarded as a half-close.
+        - Empty pipes are pooled per worker to save two syscalls per connection.
+        - With a RateLimiter attached, each new connection spends a token of
+          its client address's bucket; over the limit it is closed at once.
+        - The balancer gets the upstream connect time as the latency sample,
+          taken when the handshake completes; at close only the outcome is
+          reported. A connection's lifetime says nothing about the backend.
+*/
+class TcpProxy{
+        struct Pipe{
+            int     r{-1}, w{-1};
+            size_t  buffered{0};
+            bool    eof{false}, shut{false};
+        };
+
+        struct Session;
+        struct Endpoint{
+            Session *s;
+        };
+
+        struct Session{
+            int         client{-1}, upstream{-1};
+            Lease       lease;
+            int64_t     started{0};
+            bool        connected{false}, failed{false}, closed{false};
+            Pipe        up, down;           // client -> upstream, upstream -> client
+            Endpoint    ep{this};
+        };
+
+        struct Worker{
+            int                 listenFd{-1}, epollFd{-1}, wakeFd{-1};
+            thread              loop;
+            vector<Pipe>        freePipes;
+            unordered_set<Session*> open;
+            vector<Session*>    closing;
+        };
+
+        LoadBalancer            &lb;
+        string                  host;
+        int                     port{0};
+        atomic<bool>            stopping{false};
+        vector<unique_ptr<Worker>> workers;
+        atomic<long>            accepted{0}, failedConnects{0}, limited{0};
+        atomic<RateLimiter*>    limiter{nullptr};
+
+        static inline char LISTEN_TAG, WAKE_TAG;
+
+        static int listenOn(const string& host, int port){
+            sockaddr_in sa{};
+            sa.sin_family = AF_INET;
+            sa.sin_port = htons(port);
+            if(inet_pton(AF_INET, host.c_str(), &sa.sin_addr) != 1)
+                throw invalid_argument("proxy cannot listen on " + host + ", expected an IPv4 address");
+
+            int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if(fd < 0)
+                throw runtime_error("proxy cannot create a socket");
+            int one = 1;
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+            setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof one);
+            if(bind(fd, (sockaddr*)&sa, sizeof sa) != 0 || listen(fd, 4096) != 0){
+                close(fd);
+                throw runtime_error("proxy cannot listen on " + host + ":" + to_string(port));
+            }
+            return fd;
+        }
+
+        static Pipe takePipe(Worker& w){
+            if(!w.freePipes.empty()){
+                Pipe p = w.freePipes.back();
+                w.freePipes.pop_back();
+                return p;
+            }
+            int fds[2];
+            if(pipe2(fds, O_NONBLOCK | O_CLOEXEC) != 0)
+                return {};
+            return {fds[0], fds[1]};
+        }
+
+        static void givePipe(Worker& w, Pipe& p){
+            if(p.r < 0)
+                return;
+            if(p.buffered == 0 && w.freePipes.size() < 1024)
+                w.freePipes.push_back({p.r, p.w});
+            else {
+                close(p.r);
+                close(p.w);
+            }
+            p.r = p.w = -1;
+        }
+
+        // Moves as much as possible src -> pipe -> dst; false on a hard error
+        static bool pump(int src, Pipe& p, int dst){
+            while(true){
+                if(p.buffered > 0){
+                    ssize_t n = splice(p.r, nullptr, dst, nullptr, p.buffered, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+                    if(n > 0){
+                        p.buffered -= n;
+                        continue;
+                    }
+                    if(n < 0 && errno != EAGAIN)
+                        return false;
+                    break;                              // dst is full, wait for EPOLLOUT
+                }
+                if(p.eof)
+                    break;
+
+                ssize_t n = splice(src, nullptr, p.w, nullptr, 1 << 16, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+                if(n > 0)
+                    p.buffered += n;
+                else if(n == 0)
+                    p.eof = true;
+                else if(errno == EAGAIN)
+                    break;                              // src is empty (or the pipe is full)
+                else
+                    return false;
+            }
+
+            if(p.eof && p.buffered == 0 && !p.shut){
+                shutdown(dst, SHUT_WR);
+                p.shut = true;
+            }
+            return true;
+        }
+
+        void finish(Worker& w, Session *s){
+            if(s->closed)
+                return;
+            s->closed = true;
+            s->lease.report(!s->failed);
+            close(s->client);
+            if(s->upstream >= 0)
+                close(s->upstream);
+            givePipe(w, s->up);
+            givePipe(w, s->down);
+            w.open.erase(s);
+            w.closing.push_back(s);         // Freed after this epoll batch
+        }
+
+        void onAccept(Worker& w){
+            while(true){
+                sockaddr_in peer{};
+                socklen_t peerLen = sizeof peer;
+                int c = accept4(w.listenFd, (sockaddr*)&peer, &peerLen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if(c < 0)
+                    return;
+                accepted.fetch_add(1, memory_order_relaxed);
+                RateLimiter *rl = limiter.load(memory_order_acquire);
+                if(rl && !rl->allow(ntohl(peer.sin_addr.s_addr))){
+                    limited.fetch_add(1, memory_order_relaxed);
+                    close(c);
+                    continue;
+                }
+                int one = 1;
+                setsockopt(c, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+
+                auto s = new Session();
+                w.open.insert(s);
+                s->client = c;
+                s->started = steadyNowNs();
+                s->lease = lb.acquire(mix64(peer.sin_addr.s_addr));
+                s->up = takePipe(w);
+                s->down = takePipe(w);
+                s->upstream = s->lease ? tcpConnectAsync(s->lease.backend()->address) : -1;
+                if(s->upstream < 0 || s->up.r < 0 || s->down.r < 0){
+                    failedConnects.fetch_add(1, memory_order_relaxed);
+                    s->failed = true;
+                    finish(w, s);
+                    continue;
+                }
+
+                epoll_event ev{};
+                ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+                ev.data.ptr = &s->ep;
+                epoll_ctl(w.epollFd, EPOLL_CTL_ADD, s->upstream, &ev);
+                // The client is only read once the upstream is connected
+                epoll_ctl(w.epollFd, EPOLL_CTL_ADD, s->client, &ev);
+            }
+        }
+
+        void onSession(Worker& w, Session *s){
+            if(s->closed)
+                return;
+
+            if(!s->connected){
+                int err = 0;
+                socklen_t len = sizeof err;
+                getsockopt(s->upstream, SOL_SOCKET, SO_ERROR, &err, &len);
+                if(err != 0){
+                    failedConnects.fetch_add(1, memory_order_relaxed);
+                    s->failed = true;
+                    finish(w, s);
+                    return;
+                }
+                // Still connecting: no error yet but not writable either
+                pollfd pfd{s->upstream, POLLOUT, 0};
+                if(poll(&pfd, 1, 0) != 1)
+                    return;
+                s->connected = true;
+                s->lease.observe(steadyNowNs() - s->started);
+            }
+
+            if(!pump(s->client, s->up, s->upstream) || !pump(s->upstream, s->down, s->client)){
+                s->failed = true;
+                finish(w, s);
+                return;
+            }
+            if(s->up.shut && s->down.shut)
+                finish(w, s);
+        }
+
+        void run(Worker& w){
+            epoll_event events[256];
+            while(!stopping.load(memory_order_relaxed)){
+                int n = epoll_wait(w.epollFd, events, 256, -1);
+                for(int i = 0; i < n; i++){
+                    void *tag = events[i].data.ptr;
+                    if(tag == &LISTEN_TAG)
+                        onAccept(w);
+                    else if(tag != &WAKE_TAG)
+                        onSession(w, static_cast<Endpoint*>(tag)->s);
+                }
+                for(auto s : w.closing)
+                    delete s;
+                w.closing.clear();
+            }
+        }
+
+    public:
+        // `_host` is the IPv4 address to listen on, e.g. "0.0.0.0" for every interface
+        TcpProxy(LoadBalancer& _lb, int _port=0, int threads=max(1u, thread::hardware_concurrency()), string _host="127.0.0.1")
+            : lb(_lb), host(move(_host)), port(_port) {
+            for(int t = 0; t < threads; t++){
+                workers.push_back(make_unique<Worker>());
+                Worker *w = workers.back().get();
+                try {
+                    w->listenFd = listenOn(host, port);
+                    w->epollFd = epoll_create1(EPOLL_CLOEXEC);
+                    w->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+                    if(w->epollFd < 0 || w->wakeFd < 0)
+                        throw runtime_error("proxy cannot create its epoll or wake-up fd");
+                } catch(...){
+                    // No loop runs yet, closing the fds is all there is to undo
+                    for(auto& built : workers)
+                        for(int fd : {built->listenFd, built->epollFd, built->wakeFd})
+                            if(fd >= 0)
+                                close(fd);
+                    throw;
+                }
+                if(port == 0){
+                    sockaddr_in sa{};
+                    socklen_t len = sizeof sa;
+                    getsockname(w->listenFd, (sockaddr*)&sa, &len);
+                    port = ntohs(sa.sin_port);
+                }
+
+                epoll_event ev{};
+                ev.events = EPOLLIN | EPOLLET;
+                ev.data.ptr = &LISTEN_TAG;
+                epoll_ctl(w->epollFd, EPOLL_CTL_ADD, w->listenFd, &ev);
+                ev.data.ptr = &WAKE_TAG;
+                epoll_ctl(w->epollFd, EPOLL_CTL_ADD, w->wakeFd, &ev);
+            }
+            for(auto& w : workers)
+                w->loop = thread(&TcpProxy::run, this, ref(*w));
+        }
+
+        // Stops accepting; connections still open are cut
+        ~TcpProxy(){
+            stopping = true;
+            for(auto& w : workers){
+                uint64_t one = 1;
+                (void)!write(w->wakeFd, &one, sizeof one);
+                w->loop.join();
+                for(auto s : vector<Session*>(w->open.begin(), w->open.end())){
+                    s->failed = true;
+                    finish(*w, s);
+                }
+                for(auto s : w->closing)
+                    delete s;
+                close(w->listenFd);
+                close(w->epollFd);
+                close(w->wakeFd);
+                for(auto& p : w->freePipes){
+                    close(p.r);
+                    close(p.w);
+                }
+            }
+        }
+
+        // Limits new connections per client IP; nullptr switches it off
+        void limitClients(RateLimiter *rl){ limiter.store(rl, memory_order_release); }
+
+        string address() const { return host + ":" + to_string(port); }
+        long   acceptedCount() const { return accepted; }
+        long   failedCount() const { return failedConnects; }
+        long   limitedCount() const { return limited; }
+};
+
+void setBlocking(int fd){
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+}
+
+bool writeAll(int fd, const char *buf, size_t len){
+    while(len > 0){
+        ssize_t n = write(fd, buf, len);
+        if(n <= 0)
+            return false;
+        buf += n;
+        len -= n;
+    }
+    return true;
+}
+
+// Thread-per-connection echo, good enough for a stand-in backend
+void echoConnection(int c){
+    thread([c]{
+        int one = 1;
+        setsockopt(c, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+        char buf[1 << 16];
+        ssize_t n;
+        while((n = read(c, buf, sizeof buf)) > 0)
+            if(!writeAll(c, buf, n))
+                break;
+        close(c);
+    }).detach();
+}
+
+/*
+    Connection Pool:
+        - Idle upstream connections are kept per backend in a per-thread shard,
+          so get/put never lock: a thread reuses the connection it used last
+          (LIFO keeps the warmest one in use and lets the rest age out).
+        - A pooled connection is dropped if it has been idle longer than
+          maxIdle, is older than maxAge, or fails a liveness check: a
+          non-blocking MSG_PEEK that must find nothing to read and no EOF.
+        - Prewarmed connections go to a shared per-backend list that any
+          thread draws from when its own shard is empty; that is the only path
+          with a lock. When a backend joins, the pool's own thread opens them,
+          all handshakes in parallel, so addBackend() never waits on a connect.
+          The list is capped and aged like a shard's.
+        - When a backend leaves its shared list is closed at once; each thread
+          closes what its shard still holds for it on its next get/put.
+*/
+class ConnectionPool{
+    public:
+        struct Config{
+            chrono::milliseconds    maxIdle{30000}, maxAge{300000};
+            size_t                  maxIdlePerBackend{16};
+            int                     prewarm{4};
+            int                     connectTimeoutMs{200};
+        };
+
+    private:
+        struct Conn{
+            int     fd;
+            int64_t created, lastUsed;
+        };
+
+        struct Shard{
+            unordered_map<int, vector<Conn>> idle;     // backend id -> idle connections, most recent last
+            uint64_t                         departures{0};
+        };
+
+        static inline atomic<uint64_t> seqPool{1};
+
+        const uint64_t                  poolId{seqPool++};
+        Config                          cfg;
+        LoadBalancer                    *lb{nullptr};   // Set when following a balancer's membership
+        uint64_t                        joinHook{0}, leaveHook{0};
+        mutex                           m;
+        vector<unique_ptr<Shard>>       shards;         // Owned here so the destructor can close everything
+        unordered_map<int, vector<Conn>> warm;          // Guarded by m, as are the next four
+        unordered_set<int>              departed;       // Ids of backends that left the balancer
+        deque<Backend*>                 toWarm;
+        condition_variable              warmCv;
+        bool                            stopping{false};
+        thread                          warmer;
+        atomic<uint64_t>                departures{0};  // Bumped when a backend leaves; shards purge when it moves
+        atomic<long>                    opened{0}, reused{0}, discarded{0};
+
+        Shard& local(){
+            static thread_local unordered_map<uint64_t, Shard*> mine;
+            Shard *sh;
+            auto it = mine.find(poolId);
+            if(it != mine.end())
+                sh = it->second;
+            else {
+                lock_guard<mutex> lk(m);
+                shards.push_back(make_unique<Shard>());
+                sh = mine[poolId] = shards.back().get();
+            }
+            if(sh->departures != departures.load(memory_order_acquire))
+                purge(*sh);
+            return *sh;
+        }
+
+        // Closes what a thread's shard still keeps for backends that left
+        void purge(Shard& sh){
+            lock_guard<mutex> lk(m);
+            for(int id : departed){
+                auto it = sh.idle.find(id);
+                if(it == sh.idle.end())
+                    continue;
+                for(auto& c : it->second)
+                    close(c.fd);
+                discarded.fetch_add(it->second.size(), memory_order_relaxed);
+                sh.idle.erase(it);
+            }
+            sh.departures = departures.load(memory_order_relaxed);
+        }
+
+        bool expired(const Conn& c, int64_t now) const {
+            return now - c.lastUsed > chrono::duration_cast<chrono::nanoseconds>(cfg.maxIdle).count()
+                || now - c.created > chrono::duration_cast<chrono::nanoseconds>(cfg.maxAge).count();
+        }
+
+        bool usable(const Conn& c, int64_t now){
+            if(expired(c, now))
+                return false;
+            char b;
+            ssize_t n = recv(c.fd, &b, 1, MSG_PEEK | MSG_DONTWAIT);
+            return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+
+        int open(const Backend& b){
+            int fd = tcpConnect(b.address, cfg.connectTimeoutMs);
+            if(fd >= 0){
+                setBlocking(fd);
+                opened.fetch_add(1, memory_order_relaxed);
+            }
+            return fd;
+        }
+
+        int popUsable(vector<Conn>& list, int64_t now, int64_t& created){
+            while(!list.empty()){
+                Conn c = list.back();
+                list.pop_back();
+                if(usable(c, now)){
+                    created = c.created;
+                    return c.fd;
+                }
+                close(c.fd);
+                discarded.fetch_add(1, memory_order_relaxed);
+            }
+            return -1;
+        }
+
+    public:
+        /*
+            A checked-out connection. Call reuse() once the exchange finished
+            cleanly to hand it back; otherwise it is closed on destruction.
+        */
+        class Handle{
+                ConnectionPool  *pool{nullptr};
+                int             backendId{0}, sock{-1};
+                int64_t         created{0};
+            public:
+                Handle() = default;
+                Handle(ConnectionPool *p, int bid, int fd, int64_t c) : pool(p), backendId(bid), sock(fd), created(c) {}
+                Handle(Handle&& o) noexcept : pool(o.pool), backendId(o.backendId), sock(exchange(o.sock, -1)), created(o.created) {}
+                Handle& operator=(Handle&& o) noexcept {
+                    if(this != &o){
+                        if(sock >= 0) close(sock);
+                        pool = o.pool; backendId = o.backendId; sock = exchange(o.sock, -1); created = o.created;
+                    }
+                    return *this;
+                }
+                ~Handle() { if(sock >= 0) close(sock); }
+
+                int fd() const { return sock; }
+                explicit operator bool() const { return sock >= 0; }
+
+                void reuse(){
+                    if(sock >= 0)
+                        pool->put(backendId, exchange(sock, -1), created);
+                }
+        };
+
+        explicit ConnectionPool(Config _cfg) : cfg(_cfg) {}
+
+        // Prewarms every backend that joins `_lb` from now on, and drops the connections of those that leave
+        ConnectionPool(LoadBalancer& _lb, Config _cfg) : cfg(_cfg), lb(&_lb) {
+            warmer = thread([this]{
+                unique_lock<mutex> lk(m);
+                while(true){
+                    warmCv.wait(lk, [&]{ return stopping || !toWarm.empty(); });
+                    if(stopping)
+                        return;
+                    Backend *b = toWarm.front();
+                    toWarm.pop_front();
+                    lk.unlock();
+                    prewarm(*b, cfg.prewarm);
+                    lk.lock();
+                }
+            });
+            joinHook = lb->onBackendJoin([this](Backend *b){
+                {
+                    lock_guard<mutex> lk(m);
+                    toWarm.push_back(b);
+                }
+                warmCv.notify_one();
+            });
+            leaveHook = lb->onBackendLeave([this](Backend *b){ forget(b->id); });
+        }
+
+        ~ConnectionPool(){
+            if(lb){
+                lb->removeHook(joinHook);
+                lb->removeHook(leaveHook);
+                {
+                    lock_guard<mutex> lk(m);
+                    stopping = true;
+                }
+                warmCv.notify_one();
+                warmer.join();
+            }
+            for(auto& sh : shards)
+                for(auto& x : sh->idle)
+                    for(auto& c : x.second)
+                        close(c.fd);
+            for(auto& x : warm)
+                for(auto& c : x.second)
+                    close(c.fd);
+        }
+
+        Handle get(const Backend& b){
+            int64_t now = steadyNowNs(), created = now;
+            int fd = popUsable(local().idle[b.id], now, created);
+            if(fd < 0){
+                lock_guard<mutex> lk(m);
+                auto it = warm.find(b.id);
+                if(it != warm.end())
+                    fd = popUsable(it->second, now, created);
+            }
+            if(fd >= 0){
+                reused.fetch_add(1, memory_order_relaxed);
+                return Handle(this, b.id, fd, created);
+            }
+            return Handle(this, b.id, open(b), now);
+        }
+
+        void put(int backendId, int fd, int64_t created){
+            auto& list = local().idle[backendId];
+            if(list.size() >= cfg.maxIdlePerBackend){
+                close(list.front().fd);             // Oldest goes
+                list.erase(list.begin());
+                discarded.fetch_add(1, memory_order_relaxed);
+            }
+            list.push_back({fd, created, steadyNowNs()});
+        }
+
+        // Opens `n` connections with all handshakes in flight at once, bounded by one connect timeout
+        void prewarm(const Backend& b, int n){
+            vector<pollfd> wait;
+            for(int i = 0; i < n; i++){
+                int fd = tcpConnectAsync(b.address);
+                if(fd >= 0)
+                    wait.push_back({fd, POLLOUT, 0});
+            }
+
+            vector<Conn> fresh;
+            int64_t deadline = steadyNowNs() + cfg.connectTimeoutMs * 1000000LL;
+            while(!wait.empty()){
+                int64_t left = deadline - steadyNowNs();
+                if(left <= 0 || poll(wait.data(), wait.size(), (int)((left + 999999) / 1000000)) <= 0)
+                    break;
+                size_t keep = 0;
+                for(auto& p : wait){
+                    if(!p.revents){
+                        wait[keep++] = p;
+                        continue;
+                    }
+                    int err = 0;
+                    socklen_t len = sizeof err;
+                    if((p.revents & POLLOUT) && getsockopt(p.fd, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err == 0){
+                        setBlocking(p.fd);
+                        opened.fetch_add(1, memory_order_relaxed);
+                        fresh.push_back({p.fd, steadyNowNs(), steadyNowNs()});
+                    } else
+                        close(p.fd);
+                }
+                wait.resize(keep);
+            }
+            for(auto& p : wait)
+                close(p.fd);
+
+            lock_guard<mutex> lk(m);
+            if(departed.count(b.id)){
+                for(auto& c : fresh)
+                    close(c.fd);
+                return;
+            }
+            auto& list = warm[b.id];
+            list.insert(list.end(), fresh.begin(), fresh.end());
+
+            // Same limits as a shard: nothing past maxIdle/maxAge, at most maxIdlePerBackend (oldest go)
+            int64_t now = steadyNowNs();
+            size_t drop = 0;
+            while(drop < list.size() && (expired(list[drop], now) || list.size() - drop > cfg.maxIdlePerBackend))
+                close(list[drop++].fd);
+            list.erase(list.begin(), list.begin() + drop);
+            discarded.fetch_add(drop, memory_order_relaxed);
+        }
+
+        // Closes the shared connections of a backend that left; thread shards follow on their next get/put
+        void forget(int backendId){
+            lock_guard<mutex> lk(m);
+            departed.insert(backendId);
+            toWarm.erase(remove_if(toWarm.begin(), toWarm.end(), [&](Backend *b){ return b->id == backendId; }), toWarm.end());
+            auto it = warm.find(backendId);
+            if(it != warm.end()){
+                for(auto& c : it->second)
+                    close(c.fd);
+                discarded.fetch_add(it->second.size(), memory_order_relaxed);
+                warm.erase(it);
+            }
+            departures.fetch_add(1, memory_order_release);
+        }
+
+        long openedCount()    const { return opened; }
+        long reusedCount()    const { return reused; }
+        long discardedCount() const { return discarded; }
+};
+
+unique_ptr<SelectionStrategy> makeStrategy(const string& name){
+    if(name == "round-robin")           return make_unique<RoundRobin>();
+    if(name == "weighted-round-robin")  return make_unique<WeightedRoundRobin>();
+    if(name == "least-connections")     return make_unique<LeastConnections>();
+    if(name == "power-of-two-choices")  return make_unique<PowerOfTwoChoices>();
+    if(name == "peak-ewma")             return make_unique<PeakEwmaP2C>();
+    if(name == "ring-hash")             return make_unique<RingHash>();
+    if(name == "jump-hash")             return make_unique<JumpHash>();
+    if(name == "maglev")                return make_unique<Maglev>();
+    throw invalid_argument("unknown strategy " + name);
+}
+
+const vector<string> STRATEGIES = {"round-robin", "weighted-round-robin", "least-connections", "power-of-two-choices", "peak-ewma"};
+const vector<string> HASH_STRATEGIES = {"ring-hash", "jump-hash", "maglev"};
+
+volatile uint64_t benchSink;     // Keeps benchmark loops from being optimized away
+
+/*
+    Selection cost: every thread acquires & releases leases in a loop while the
+    main thread keeps swapping the backend set underneath them.
+*/
+void SelectionBenchmark(const string& strategy, int opsPerThread){
+    cout << strategy << ":";
+    for(int threads = 1; threads <= 64; threads *= 4){
+        LoadBalancer lb(makeStrategy(strategy));
+        for(int i = 0; i < 16; i++)
+            lb.addBackend("10.0.0." + to_string(i) + ":80", 1 + i % 4);
+
+        atomic<bool> go{false};
+        atomic<int> running{threads};
+        vector<thread> pool;
+        for(int t = 0; t < threads; t++){
+            pool.emplace_back([&]{
+                while(!go) this_thread::yield();
+                for(int i = 0; i < opsPerThread; i++){
+                    Lease l = lb.acquire(i);
+                    if(!l) abort();
+                }
+                running--;
+            });
+        }
+
+        auto start = chrono::steady_clock::now();
+        go = true;
+        while(running > 0){                             // RCU swaps while picking
+            int id = lb.addBackend("10.0.1.1:80");
+            lb.removeBackend(id);
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        for(auto& th : pool)
+            th.join();
+
+        double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+        unsigned cores = max(1u, thread::hardware_concurrency());
+        cout << "  " << threads << "t=" << fixed << setprecision(1) << ns * min<unsigned>(threads, cores) / ((double)threads * opsPerThread) << "ns";
+    }
+    cout << "\n";
+}
+
+/*
+    Keyed routing: lookup cost, and how many of 200k keys move when a backend
+    joins 10 others (ideal 1/11) and, once it is gone again, when one in the
+    middle leaves (ideal 1/10, only its own keys). Each change is measured
+    against the table right before it.
+*/
+void ConsistentHashBenchmark(const string& strategy){
+    LoadBalancer lb(makeStrategy(strategy));
+    vector<int> ids;
+    for(int i = 0; i < 10; i++)
+        ids.push_back(lb.addBackend("10.0.0." + to_string(i) + ":80"));
+
+    const int nKeys = 200000;
+    auto owners = [&]{
+        vector<int> res(nKeys);
+        for(int k = 0; k < nKeys; k++)
+            res[k] = lb.acquire(k).backend()->id;
+        return res;
+    };
+    auto moved = [&](const vector<int>& a, const vector<int>& b){
+        int cnt = 0;
+        for(int k = 0; k < nKeys; k++)
+            cnt += a[k] != b[k];
+        return 100.0 * cnt / nKeys;
+    };
+
+    const int lookups = 2000000;
+    auto start = chrono::steady_clock::now();
+    for(int k = 0; k < lookups; k++)
+        benchSink += lb.acquire(k * 7919ULL).backend()->id;
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / lookups;
+
+    auto base = owners();
+    int extra = lb.addBackend("10.0.0.10:80");
+    auto grown = owners();
+    lb.removeBackend(extra);
+    auto before = owners();
+    lb.removeBackend(ids[4]);
+    auto shrunk = owners();
+
+    cout << setw(10) << strategy << ": " << fixed << setprecision(1) << ns << " ns/lookup, "
+         << moved(base, grown) << "% moved on join, " << moved(before, shrunk) << "% moved on leave\n";
+}
+
+/*
+    Simulation / chaos harness:
+        Discrete-event, on virtual time (clockNs is pointed at the simulation
+        clock, the HealthChecker is stepped on it too), so a run is
+        reproducible from its seed and needs no network.
+        - Each simulated backend serves `capacity` requests at a time and
+          queues up to `queueLimit` more; past that it answers 503 at once.
+          Service times follow the backend's distribution.
+        - Requests arrive open-loop (Poisson), independent of how fast the
+          backends answer, each from one of `clients` client keys, and are
+          routed through a real LoadBalancer.
+        - Faults are scripted per backend over time windows: slowdowns scale
+          service times, crashes refuse new connections and fail whatever was
+          queued or in flight, flapping is a crash for the first half of every
+          period. A refused connection costs 1ms and is retried once.
+        - Every attempt completes its Lease with the latency and outcome the
+          balancer would have seen, so latency-aware strategies and outlier
+          ejection learn exactly as they would in production.
+*/
+namespace sim{
+    int64_t now = 0;
+    int64_t clock() { return now; }
+}
+
+struct SimBackendSpec{
+    enum Dist{ CONSTANT, EXPONENTIAL, LOGNORMAL, PARETO };
+
+    double  meanMs{5};
+    int     capacity{8};
+    int     queueLimit{200};
+    Dist    dist{LOGNORMAL};
+    int     weight{1};
+};
+
+struct SimFault{
+    enum Kind{ SLOWDOWN, CRASH, FLAP };
+
+    Kind    kind;
+    int     backend;
+    double  fromS, toS;
+    double  factor{1};          // SLOWDOWN: service time multiplier
+    double  periodS{2};         // FLAP
+};
+
+struct SimScenario{
+    string                  name;
+    vector<SimBackendSpec>  backends;
+    vector<SimFault>        faults;
+    double                  requestsPerSec{8000}, seconds{20};
+    int                     clients{10000};
+};
+
+struct SimResult{
+    vector<double>  latenciesMs;        // Successful requests only
+    vector<long>    served;             // Per backend
+    long            failed{0}, retried{0};
+    double          seconds{0};
+    double          imbalance{0};       // Busiest backend's load per unit of capacity over the fleet's
+
+    double percentile(double p){
+        if(latenciesMs.empty())
+            return 0;
+        size_t k = min(latenciesMs.size() - 1, (size_t)(p / 100 * latenciesMs.size()));
+        nth_element(latenciesMs.begin(), latenciesMs.begin() + k, latenciesMs.end());
+        return latenciesMs[k];
+    }
+
+    double throughput() const { return latenciesMs.size() / seconds; }
+    double errorPercent() const { return 100.0 * failed / max<size_t>(1, latenciesMs.size() + failed); }
+};
+
+SimResult simulate(const string& strategy, const SimScenario& sc, uint64_t seed=1){
+    enum Kind{ ARRIVAL, DONE, REFUSED, CRASH, HEALTH };
+    struct Event{
+        int64_t at;
+        int     kind;
+        int     id;             // Request, or backend for CRASH
+        bool operator>(const Event& o) const { return at != o.at ? at > o.at : kind < o.kind; }
+    };
+    struct Request{
+        Lease       lease;
+        uint64_t    client{0};
+        int64_t     arrived{0}, attemptStart{0};
+        int         node{-1}, attempts{0};
+        bool        finished{false};
+    };
+    struct Node{
+        deque<int>          queue;
+        unordered_set<int>  running;
+    };
+
+    const auto& specs = sc.backends;
+    const int64_t SEC = 1'000'000'000, CONNECT_REFUSED = 1'000'000;
+
+    auto oldClock = clockNs;
+    clockNs = sim::clock;
+    sim::now = 0;
+
+    auto down = [&](int node, int64_t t){
+        for(auto& f : sc.faults){
+            int64_t from = f.fromS * SEC, to = f.toS * SEC, period = f.periodS * SEC;
+            if(f.backend != node || t < from || t >= to)
+                continue;
+            if(f.kind == SimFault::CRASH || (f.kind == SimFault::FLAP && (t - from) % period < period / 2))
+                return true;
+        }
+        return false;
+    };
+    auto slowdown = [&](int node, int64_t t){
+        double x = 1;
+        for(auto& f : sc.faults)
+            if(f.kind == SimFault::SLOWDOWN && f.backend == node && t >= f.fromS * SEC && t < f.toS * SEC)
+                x *= f.factor;
+        return x;
+    };
+
+    LoadBalancer lb(makeStrategy(strategy));
+    unordered_map<int, int> nodeOf;
+    for(size_t i = 0; i < specs.size(); i++)
+        nodeOf[lb.addBackend("sim-" + to_string(i), specs[i].weight)] = i;
+
+    HealthChecker::Config hcfg;
+    hcfg.probeInterval = chrono::milliseconds(1000);
+    hcfg.outlierInterval = chrono::milliseconds(500);
+    hcfg.baseEjection = chrono::milliseconds(2000);
+    hcfg.ownThread = false;
+    hcfg.seed = seed;
+    HealthChecker hc(lb, hcfg, [&](const Backend& b){ return !down(nodeOf.at(b.id), sim::now); });
+
+    mt19937_64 rng(seed);
+    const int nRequests = sc.requestsPerSec * sc.seconds;
+    vector<Node> nodes(specs.size());
+    vector<Request> reqs(nRequests);
+    priority_queue<Event, vector<Event>, greater<Event>> events;
+
+    SimResult res;
+    res.served.assign(specs.size(), 0);
+    res.seconds = sc.seconds;
+    int finished = 0;
+
+    auto service = [&](const SimBackendSpec& sp){
+        double mean = sp.meanMs * 1e6;
+        switch(sp.dist){
+            case SimBackendSpec::CONSTANT:      return mean;
+            case SimBackendSpec::EXPONENTIAL:   return exponential_distribution<double>(1 / mean)(rng);
+            case SimBackendSpec::LOGNORMAL:     return lognormal_distribution<double>(log(mean) - 0.125, 0.5)(rng);     // sigma 0.5
+            case SimBackendSpec::PARETO:        return mean * 0.6 / pow(1 - uniform_real_distribution<double>()(rng), 1 / 2.5);  // alpha 2.5
+        }
+        return mean;
+    };
+
+    auto start = [&](int node, int id){
+        nodes[node].running.insert(id);
+        events.push({sim::now + (int64_t)(service(specs[node]) * slowdown(node, sim::now)), DONE, id});
+    };
+
+    auto finish = [&](int id, bool ok){
+        Request& r = reqs[id];
+        r.lease.complete(sim::now - r.attemptStart, ok);
+        r.finished = true;
+        finished++;
+        if(ok){
+            res.served[r.node]++;
+            res.latenciesMs.push_back((sim::now - r.arrived) / 1e6);
+        } else
+            res.failed++;
+    };
+
+    auto dispatch = [&](int id){
+        Request& r = reqs[id];
+        r.lease = lb.acquire(r.client);
+        r.node = nodeOf[r.lease.backend()->id];
+        r.attemptStart = sim::now;
+        Node& n = nodes[r.node];
+        if(down(r.node, sim::now))
+            events.push({sim::now + CONNECT_REFUSED, REFUSED, id});
+        else if((int)n.running.size() < specs[r.node].capacity)
+            start(r.node, id);
+        else if((int)n.queue.size() < specs[r.node].queueLimit)
+            n.queue.push_back(id);
+        else
+            finish(id, false);                  // 503
+    };
+
+    uniform_int_distribution<uint64_t> client(1, sc.clients);
+    exponential_distribution<double> gap(sc.requestsPerSec / 1e9);
+    int64_t t = 0;
+    for(int id = 0; id < nRequests; id++){
+        t += (int64_t)gap(rng);
+        reqs[id].client = client(rng);
+        events.push({t, ARRIVAL, id});
+    }
+    for(auto& f : sc.faults)
+        if(f.kind != SimFault::SLOWDOWN)
+            for(double at = f.fromS; at < f.toS; at += f.kind == SimFault::FLAP ? f.periodS : f.toS)
+                events.push({(int64_t)(at * SEC), CRASH, f.backend});
+    events.push({0, HEALTH, 0});
+
+    while(finished < nRequests){
+        Event e = events.top();
+        events.pop();
+        sim::now = e.at;
+        Request& r = reqs[e.id];
+
+        switch(e.kind){
+            case ARRIVAL:
+                r.arrived = sim::now;
+                dispatch(e.id);
+                break;
+
+            case REFUSED:
+                if(++r.attempts < 2){
+                    r.lease.complete(sim::now - r.attemptStart, false);
+                    res.retried++;
+                    dispatch(e.id);
+                } else
+                    finish(e.id, false);
+                break;
+
+            case DONE: {
+                if(r.finished)                  // Already failed by a crash
+                    break;
+                Node& n = nodes[r.node];
+                n.running.erase(e.id);
+                finish(e.id, true);
+                if(!n.queue.empty()){
+                    int next = n.queue.front();
+                    n.queue.pop_front();
+                    start(r.node, next);
+                }
+                break;
+            }
+
+            case CRASH: {
+                Node& n = nodes[e.id];
+                for(int id : n.running)
+                    finish(id, false);
+                for(int id : n.queue)
+                    finish(id, false);
+                n.running.clear();
+                n.queue.clear();
+                break;
+            }
+
+            case HEALTH:
+                events.push({hc.advance(sim::now), HEALTH, 0});
+                break;
+        }
+    }
+
+    double total = 0, capacity = 0, busiest = 0;
+    for(size_t i = 0; i < specs.size(); i++){
+        total += res.served[i];
+        capacity += specs[i].capacity / specs[i].meanMs;
+        busiest = max(busiest, res.served[i] / (specs[i].capacity / specs[i].meanMs));
+    }
+    res.imbalance = total > 0 ? busiest / (total / capacity) : 0;
+
+    clockNs = oldClock;
+    return res;
+}
+
+// Every strategy against the same scripted failures, same seed
+void ChaosHarness(){
+    vector<SimBackendSpec> fleet(10, SimBackendSpec{});
+
+    vector<SimBackendSpec> mixed;
+    for(int i = 0; i < 10; i++)
+        mixed.push_back(i < 6 ? SimBackendSpec{5, 8, 200, SimBackendSpec::PARETO, 1} : SimBackendSpec{5, 16, 400, SimBackendSpec::PARETO, 2});
+
+    vector<SimScenario> scenarios = {
+        {"steady: 10 backends, 90% utilised", fleet, {}, 14400},
+        {"slowdown: #3 is 5x slower from 5s to 15s", fleet, {{SimFault::SLOWDOWN, 3, 5, 15, 5}}},
+        {"crash: #7 dies at 5s", fleet, {{SimFault::CRASH, 7, 5, 20}}},
+        {"flapping: #2 down 1s of every 2s from 3s to 17s", fleet, {{SimFault::FLAP, 2, 3, 17, 1, 2}}},
+        {"mixed fleet: 4 of 10 have 2x capacity, Pareto service times", mixed, {}, 12000},
+    };
+
+    vector<string> strategies = STRATEGIES;
+    strategies.push_back("maglev");
+
+    for(auto& sc : scenarios){
+        cout << sc.name << "\n";
+        cout << "  " << left << setw(22) << "strategy" << right << setw(8) << "ok/s" << setw(8) << "err%" << setw(9) << "p50"
+             << setw(9) << "p99" << setw(10) << "p99.9" << setw(11) << "imbalance" << "\n";
+        for(auto& name : strategies){
+            SimResult r = simulate(name, sc);
+            cout << "  " << left << setw(22) << name << right << fixed << setprecision(0) << setw(8) << r.throughput()
+                 << setprecision(2) << setw(8) << r.errorPercent() << setprecision(1) << setw(7) << r.percentile(50) << "ms"
+                 << setw(7) << r.percentile(99) << "ms" << setw(8) << r.percentile(99.9) << "ms" << setprecision(2) << setw(11) << r.imbalance << "\n";
+        }
+    }
+}
+
+// Kill a stand-in backend, then make another one fail requests, and watch both leave & come back
+void HealthCheckDemo(){
+    LoadBalancer lb(make_unique<RoundRobin>());
+    auto a = make_unique<LocalServer>(), b = make_unique<LocalServer>(), c = make_unique<LocalServer>();
+    int portA = a->getPort();
+    lb.addBackend(a->address());
+    int idB = lb.addBackend(b->address());
+    lb.addBackend(c->address());
+
+    HealthChecker::Config cfg;
+    cfg.probeInterval = chrono::milliseconds(30);
+    cfg.outlierInterval = chrono::milliseconds(30);
+    cfg.baseEjection = chrono::milliseconds(150);
+    HealthChecker hc(lb, cfg);
+
+    auto waitFor = [&](int routable, const string& what){
+        auto start = chrono::steady_clock::now();
+        while(lb.routableCount() != routable && chrono::steady_clock::now() - start < chrono::seconds(3))
+            this_thread::sleep_for(chrono::milliseconds(5));
+        cout << what << ": " << lb.routableCount() << " routable after "
+             << chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count() << " ms\n";
+    };
+
+    a.reset();
+    waitFor(2, "backend A stopped (active probe)");
+    a = make_unique<LocalServer>([](int c){ close(c); }, portA);
+    waitFor(3, "backend A restarted");
+
+    for(int i = 0; i < 50; i++){
+        Lease l = lb.acquire();
+        l.complete(1000000, l.backend()->id != idB);
+    }
+    waitFor(2, "backend B failing requests (passive ejection)");
+    waitFor(3, "backend B ejection expired");
+}
+
+/*
+    Proxy vs direct, against loopback echo servers:
+        - latency    : 1-byte ping-pong on one connection, the difference is
+                       what the extra hop adds
+        - throughput : one connection streaming both ways
+        - conn/sec   : connect, 1-byte round trip, close, from 4 client threads
+*/
+void ProxyBenchmark(){
+    vector<unique_ptr<LocalServer>> echos;
+    LoadBalancer lb(make_unique<LeastConnections>());
+    for(int i = 0; i < 2; i++){
+        echos.push_back(make_unique<LocalServer>(echoConnection));
+        lb.addBackend(echos.back()->address());
+    }
+    TcpProxy proxy(lb);
+
+    auto open = [](const string& address){
+        int fd = tcpConnect(address, 1000);
+        if(fd < 0)
+            throw runtime_error("cannot connect to " + address);
+        setBlocking(fd);
+        return fd;
+    };
+
+    auto pingPongUs = [&](const string& address){
+        int fd = open(address);
+        char c = 'x';
+        const int rounds = 5000;
+        auto start = chrono::steady_clock::now();
+        for(int i = 0; i < rounds; i++)
+            if(write(fd, &c, 1) != 1 || read(fd, &c, 1) != 1)
+                throw runtime_error("ping-pong failed");
+        close(fd);
+        return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / rounds;
+    };
+
+    auto throughputMBs = [&](const string& address){
+        int fd = open(address);
+        const size_t total = 256 << 20;
+        thread writer([fd, total]{
+            vector<char> buf(1 << 16, 'x');
+            for(size_t sent = 0; sent < total; sent += buf.size())
+                writeAll(fd, buf.data(), buf.size());
+            shutdown(fd, SHUT_WR);
+        });
+        vector<char> buf(1 << 16);
+        size_t got = 0;
+        auto start = chrono::steady_clock::now();
+        for(ssize_t n; (n = read(fd, buf.data(), buf.size())) > 0; )
+            got += n;
+        double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        writer.join();
+        close(fd);
+        if(got != total)
+            throw runtime_error("stream lost bytes");
+        return total / secs / (1 << 20);
+    };
+
+    auto connsPerSec = [&](const string& address){
+        const int threads = 4, perThread = 1000;
+        auto start = chrono::steady_clock::now();
+        vector<thread> pool;
+        for(int t = 0; t < threads; t++){
+            pool.emplace_back([&]{
+                for(int i = 0; i < perThread; i++){
+                    int fd = open(address);
+                    char c = 'x';
+                    if(write(fd, &c, 1) != 1 || read(fd, &c, 1) != 1)
+                        throw runtime_error("round trip failed");
+                    close(fd);
+                }
+            });
+        }
+        for(auto& th : pool)
+            th.join();
+        return threads * perThread / chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    };
+
+    string direct = echos[0]->address(), viaProxy = proxy.address();
+    double dLat = pingPongUs(direct), pLat = pingPongUs(viaProxy);
+    cout << fixed << setprecision(1);
+    cout << "round trip : direct " << dLat << " us, proxied " << pLat << " us, +" << (pLat - dLat) / 2 << " us per hop per direction\n";
+    cout << "throughput : direct " << throughputMBs(direct) << " MB/s, proxied " << throughputMBs(viaProxy) << " MB/s\n";
+    cout << setprecision(0);
+    cout << "conn/sec   : direct " << connsPerSec(direct) << ", proxied " << connsPerSec(viaProxy) << "\n";
+    cout << "proxy accepted " << proxy.acceptedCount() << " connections, " << proxy.failedCount() << " upstream failures\n";
+}
+
+/*
+    Request/response over connect-per-request vs pooled keepalive connections
+    to loopback echo backends. CPU is the whole process (client + stand-in
+    backends), from getrusage.
+*/
+void ConnectionPoolBenchmark(){
+    LoadBalancer lb(make_unique<RoundRobin>());
+    ConnectionPool::Config cfg;
+    cfg.maxIdle = chrono::milliseconds(5000);
+    ConnectionPool pool(lb, cfg);
+
+    vector<unique_ptr<LocalServer>> echos;
+    for(int i = 0; i < 3; i++){
+        echos.push_back(make_unique<LocalServer>(echoConnection));
+        lb.addBackend(echos.back()->address());       // Prewarmed by the pool's join hook
+    }
+
+    auto cpuUs = []{
+        rusage ru;
+        getrusage(RUSAGE_SELF, &ru);
+        return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1e6 + ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+    };
+
+    const int requests = 3000;
+    char req[64] = "GET /", resp[64];
+
+    auto run = [&](bool pooled){
+        double cpu0 = cpuUs();
+        auto start = chrono::steady_clock::now();
+        for(int i = 0; i < requests; i++){
+            int64_t t0 = steadyNowNs();
+            Lease lease = lb.acquire();
+            bool ok;
+            if(pooled){
+                auto conn = pool.get(*lease.backend());
+                ok = conn && writeAll(conn.fd(), req, sizeof req) && recv(conn.fd(), resp, sizeof resp, MSG_WAITALL) == sizeof resp;
+                if(ok)
+                    conn.reuse();
+            } else {
+                int fd = tcpConnect(lease.backend()->address, 200);
+                if(fd >= 0)
+                    setBlocking(fd);
+                ok = fd >= 0 && writeAll(fd, req, sizeof req) && recv(fd, resp, sizeof resp, MSG_WAITALL) == sizeof resp;
+                if(fd >= 0)
+                    close(fd);
+            }
+            lease.complete(steadyNowNs() - t0, ok);
+        }
+        double wallUs = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+        cout << (pooled ? "pooled             " : "connect-per-request") << ": " << fixed << setprecision(1)
+             << wallUs / requests << " us/request, " << (cpuUs() - cpu0) / requests << " us CPU/request\n";
+    };
+
+    run(false);
+    run(true);
+    cout << "pool: " << pool.openedCount() << " opened (incl. prewarm), " << pool.reusedCount() << " reused, "
+         << pool.discardedCount() << " discarded\n";
+
+    // Prewarming happens on the pool's thread, so joining an unreachable backend costs the caller nothing
+    auto t0 = chrono::steady_clock::now();
+    int unreachable = lb.addBackend("10.255.255.1:81");
+    double addUs = chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count();
+    lb.removeBackend(unreachable);
+    cout << "addBackend of an unreachable backend returned in " << fixed << setprecision(0) << addUs << " us\n";
+}
+
+/*
+    Rate limiter: cost per check with 4M distinct clients across threads,
+    uniform (every check misses cache) and skewed (90% of checks from 10k hot
+    clients) once every client has a bucket, then bucket accuracy and idle eviction on the simulated clock,
+    then the limiter in front of the proxy. Like a request loop reusing its
+    arrival timestamp, each thread reads the clock once per 64 checks.
+*/
+void RateLimiterBenchmark(){
+    const uint64_t keys = 4'000'000, hot = 10'000;
+    unsigned cores = max(1u, thread::hardware_concurrency());
+    for(bool skewed : {false, true}){
+        RateLimiter rl({1000, 50, chrono::milliseconds(60000)});
+        for(uint64_t k = 0; k < keys; k++)             // Steady state: every client already has a bucket
+            rl.allow(k);
+        cout << (skewed ? "skewed " : "uniform") << ":";
+        for(unsigned threads : {1u, 4u, 16u}){
+            const int perThread = 1'000'000;
+            atomic<long> allowed{0};
+            vector<thread> pool;
+            auto start = chrono::steady_clock::now();
+            for(unsigned t = 0; t < threads; t++){
+                pool.emplace_back([&]{
+                    long ok = 0;
+                    int64_t now = 0;
+                    for(int i = 0; i < perThread; i++){
+                        if(i % 64 == 0)
+                            now = clockNs();
+                        uint64_t r = threadRandom();
+                        ok += rl.allow(skewed && r % 10 ? r % hot : r % keys, now, 1);
+                    }
+                    allowed += ok;
+                });
+            }
+            for(auto& th : pool)
+                th.join();
+            double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+            cout << "  " << threads << "t=" << fixed << setprecision(1) << ns * min(threads, cores) / ((double)threads * perThread) << "ns";
+            if(threads == 16)
+                cout << " (" << rl.size() << " buckets, " << setprecision(1) << allowed * 100.0 / ((double)threads * perThread) << "% allowed)";
+        }
+        cout << "\n";
+    }
+
+    clockNs = sim::clock;
+    sim::now = 1;
+    RateLimiter rl({100, 200, chrono::milliseconds(5000)});
+    int ok = 0;
+    for(int ms = 0; ms < 10000; ms++, sim::now += 1'000'000)
+        ok += rl.allow(42);
+    cout << "one client, 1000 req/s for 10s at 100/s burst 200: " << ok << " allowed (expect ~1200)\n";
+
+    for(uint64_t k = 0; k < 100000; k++)
+        rl.allow(k);
+    size_t before = rl.size();
+    sim::now += 60'000'000'000;
+    for(uint64_t k = 0; k < 100000; k++)
+        rl.allow(1'000'000 + k);
+    cout << "after 60s idle: " << before << " -> " << rl.size() << " buckets, " << rl.evictedCount() << " evicted\n";
+    clockNs = steadyNowNs;
+
+    LoadBalancer lb(make_unique<RoundRobin>());
+    LocalServer echo(echoConnection);
+    lb.addBackend(echo.address());
+    TcpProxy proxy(lb, 0, 1);
+    RateLimiter perClient({1, 5});
+    proxy.limitClients(&perClient);
+    int served = 0;
+    for(int i = 0; i < 20; i++){
+        int fd = tcpConnect(proxy.address(), 200);
+        if(fd < 0)
+            continue;
+        setBlocking(fd);
+        char b[8] = "ping", r[8];
+        served += writeAll(fd, b, sizeof b) && recv(fd, r, sizeof r, MSG_WAITALL) == sizeof r;
+        close(fd);
+    }
+    cout << "proxy, 20 connections from one client at 1/s burst 5: " << served << " served, " << proxy.limitedCount() << " refused\n";
+}
+
 int main(){
-    cout << "Hello World!";
-}
\ No newline at end of file
+    LoadBalancer lb(make_unique<RoundRobin>());
+    lb.addBackend("10.0.0.1:80", 1);
+    lb.addBackend("10.0.0.2:80", 1);
+    lb.addBackend("10.0.0.3:80", 2);
+    lb.addBackend("10.0.0.4:80", 4);
+
+    cout << "--- Distribution over 8000 picks (weights 1,1,2,4) ---\n";
+    for(auto& name : STRATEGIES){
+        lb.setStrategy(makeStrategy(name));
+        map<int, int> hits;
+        for(int i = 0; i < 8000; i++)
+            hits[lb.acquire().backend()->id]++;
+
+        cout << lb.strategyName() << ":";
+        for(auto& x : hits)
+            cout << " #" << x.first << "=" << x.second;
+        cout << "\n";
+    }
+
+    cout << "\n--- Selection cost per pick (per core) ---\n";
+    for(auto& name : STRATEGIES)
+        SelectionBenchmark(name, 200000);
+
+    cout << "\n--- Consistent hashing (10 backends) ---\n";
+    lb.setStrategy(makeStrategy("ring-hash"));
+    cout << "user:42 -> #" << lb.acquire(hashKey("user:42")).backend()->id << ", again -> #" << lb.acquire(hashKey("user:42")).backend()->id << "\n";
+    for(auto& name : HASH_STRATEGIES)
+        ConsistentHashBenchmark(name);
+
+    cout << "\n--- Health checks & outlier ejection ---\n";
+    HealthCheckDemo();
+
+    cout << "\n--- L4 proxy vs direct (loopback echo) ---\n";
+    ProxyBenchmark();
+
+    cout << "\n--- Connection pooling (loopback echo) ---\n";
+    ConnectionPoolBenchmark();
+
+    cout << "\n--- Per-client rate limiting ---\n";
+    RateLimiterBenchmark();
+
+    cout << "\n--- Chaos harness (simulated backends, 6 strategies) ---\n";
+    ChaosHarness();
+}
@@ -15,12 +15,25 @@
         2. Builder (interface)   – declares build steps
         3. ConcreteBuilder       – implements the steps + returns the product
         4. Director (optional)   – orchestrates standard building sequences
+  • Flat mode (section 4): the same fluent steps, but build() writes the
+    whole product, strings included, as one contiguous immutable record
+    into an arena the caller owns, and hands back a view of it; nothing
+    touches the general heap.
  ----------------------------------------------------------------------------
 */
 
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
 #include <iostream>
 #include <memory>
+#include <memory_resource>
+#include <new>
 #include <string>
+#include <string_view>
+#include <vector>
 
 /* =========================================================
    1. Product – the “complex” object.
@@ -103,6 +116,211 @@ public:
     }
 };
 
+/* =========================================================
+   4. Flat products in a caller-supplied arena.
+   ---------------------------------------------------------
+   Layout of one record, 8-byte aligned:
+        [engine length][color length][flags][pad] engine color
+   FlatCar is just a pointer to it, with string_view
+   accessors into the record. The arena is any
+   std::pmr::memory_resource, typically a
+   monotonic_buffer_resource over a per-request buffer,
+   and the records live exactly as long as it does.
+   ---------------------------------------------------------*/
+class FlatCar {
+    struct Header {
+        std::uint32_t engineLen;
+        std::uint32_t colorLen;
+        std::uint8_t  flags;
+    };
+    enum : std::uint8_t { GPS = 1, AUDIO = 2 };
+
+    const Header* rec;
+
+    explicit FlatCar(const Header* h) : rec(h) {}
+    const char* text() const { return reinterpret_cast<const char*>(rec + 1); }
+
+    friend class FlatCarBuilder;
+    friend class FlatCarRange;
+
+public:
+    std::string_view engine()  const { return {text(), rec->engineLen}; }
+    std::string_view color()   const { return {text() + rec->engineLen, rec->colorLen}; }
+    bool             hasGPS()  const { return rec->flags & GPS; }
+    bool             hasAudio()const { return rec->flags & AUDIO; }
+
+    // Bytes the record takes in the arena, so the next one starts right after
+    static std::size_t recordSize(std::size_t engineLen, std::size_t colorLen) {
+        return (sizeof(Header) + engineLen + colorLen + 7) & ~std::size_t(7);
+    }
+    std::size_t size() const { return recordSize(rec->engineLen, rec->colorLen); }
+
+    void specs() const {
+        std::cout << "Car specs:\n"
+                  << "  Engine : " << engine() << '\n'
+                  << "  Color  : " << color()  << '\n'
+                  << "  GPS    : " << (hasGPS()   ? "Yes" : "No") << '\n'
+                  << "  Audio  : " << (hasAudio() ? "Yes" : "No") << '\n';
+    }
+};
+
+// Records built together, back to back in one block
+class FlatCarRange {
+    const char* first;
+    const char* last;
+    std::size_t count;
+public:
+    FlatCarRange(const void* from, const void* to, std::size_t n)
+        : first(static_cast<const char*>(from)), last(static_cast<const char*>(to)), count(n) {}
+
+    class iterator {
+        const char* at;
+    public:
+        explicit iterator(const char* p) : at(p) {}
+        FlatCar operator*() const { return FlatCar(reinterpret_cast<const FlatCar::Header*>(at)); }
+        iterator& operator++() { at += (**this).size(); return *this; }
+        bool operator!=(const iterator& o) const { return at != o.at; }
+    };
+
+    iterator begin() const { return iterator(first); }
+    iterator end()   const { return iterator(last); }
+    std::size_t size() const { return count; }
+};
+
+/*
+    Same steps as CarBuilder. The builder itself only holds
+    views and flags, so it is cheap to keep many of them;
+    the strings it was given must outlive build().
+*/
+class FlatCarBuilder {
+    std::string_view engine, color;
+    std::uint8_t     flags = 0;
+
+    std::size_t size() const { return FlatCar::recordSize(engine.size(), color.size()); }
+
+    FlatCar writeTo(void* at) const {
+        auto* h = static_cast<FlatCar::Header*>(at);
+        h->engineLen = engine.size();
+        h->colorLen  = color.size();
+        h->flags     = flags;
+        char* text = reinterpret_cast<char*>(h + 1);
+        std::memcpy(text, engine.data(), engine.size());
+        std::memcpy(text + engine.size(), color.data(), color.size());
+        return FlatCar(h);
+    }
+
+public:
+    FlatCarBuilder& setEngine(std::string_view type) {
+        engine = type;
+        return *this;
+    }
+    FlatCarBuilder& setColor(std::string_view c) {
+        color = c;
+        return *this;
+    }
+    FlatCarBuilder& addGPS() {
+        flags |= FlatCar::GPS;
+        return *this;
+    }
+    FlatCarBuilder& addAudio() {
+        flags |= FlatCar::AUDIO;
+        return *this;
+    }
+
+    // One allocation from the arena, of exactly the record's size
+    FlatCar build(std::pmr::memory_resource& arena) const {
+        return writeTo(arena.allocate(size(), 8));
+    }
+
+    /*
+        Batch: one pass to size every product, one arena
+        allocation for all of them, one pass to write them.
+    */
+    static FlatCarRange buildAll(const FlatCarBuilder* specs, std::size_t n, std::pmr::memory_resource& arena) {
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < n; i++)
+            total += specs[i].size();
+        char* block = static_cast<char*>(arena.allocate(total ? total : 8, 8));
+        for (std::size_t i = 0, at = 0; i < n; at += specs[i++].size())
+            specs[i].writeTo(block + at);
+        return FlatCarRange(block, block + total, n);
+    }
+
+    static FlatCarRange buildAll(const std::vector<FlatCarBuilder>& specs, std::pmr::memory_resource& arena) {
+        return buildAll(specs.data(), specs.size(), arena);
+    }
+};
+
+/* =========================================================
+   Benchmark – heap allocations and time per built car, by
+   CarBuilder, FlatCarBuilder::build and buildAll, with
+   strings past the small-string buffer. Allocations are
+   counted by replacing the global operator new.
+   ---------------------------------------------------------*/
+static std::size_t heapAllocations = 0;
+
+void* operator new(std::size_t n) {
+    heapAllocations++;
+    if (void* p = std::malloc(n ? n : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+void benchmark() {
+    const std::size_t N = 1'000'000, PER_REQUEST = 1000;
+    const std::string engines[] = {"Twin-turbo V8, 4.0 litre, 650 hp", "Dual-motor electric, 85 kWh pack"};
+    const std::string colors[]  = {"Metallic Midnight Black Pearl", "Arctic White with Racing Stripes"};
+
+    auto row = [&](const char* name, auto build) {
+        std::size_t before = heapAllocations;
+        std::size_t bytes = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t r = 0; r < N / PER_REQUEST; r++)
+            bytes += build();
+        double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "  " << std::left << std::setw(38) << name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(7) << s * 1e9 / N << " ns/car" << std::setprecision(2) << std::setw(7)
+                  << (double)(heapAllocations - before) / N << " heap allocs/car  (checksum " << bytes << ")\n";
+    };
+
+    std::cout << "\n--- " << N << " cars, " << PER_REQUEST << " per request ---\n";
+    row("CarBuilder (make_unique + strings)", [&] {
+        std::vector<std::unique_ptr<Car>> cars;
+        cars.reserve(PER_REQUEST);
+        std::size_t bytes = 0;
+        for (std::size_t i = 0; i < PER_REQUEST; i++) {
+            cars.push_back(CarBuilder().setEngine(engines[i % 2]).setColor(colors[i % 2]).addGPS().build());
+            bytes += cars.back()->engine.size() + cars.back()->color.size();
+        }
+        return bytes;
+    });
+
+    // Per-request arena over a buffer that is reused for every request
+    alignas(8) static char buffer[128 * 1024];
+    row("FlatCarBuilder::build, arena", [&] {
+        std::pmr::monotonic_buffer_resource arena(buffer, sizeof buffer, std::pmr::null_memory_resource());
+        std::size_t bytes = 0;
+        for (std::size_t i = 0; i < PER_REQUEST; i++) {
+            FlatCar car = FlatCarBuilder().setEngine(engines[i % 2]).setColor(colors[i % 2]).addGPS().build(arena);
+            bytes += car.engine().size() + car.color().size();
+        }
+        return bytes;
+    });
+
+    FlatCarBuilder specs[PER_REQUEST];
+    row("FlatCarBuilder::buildAll + range walk", [&] {
+        std::pmr::monotonic_buffer_resource arena(buffer, sizeof buffer, std::pmr::null_memory_resource());
+        for (std::size_t i = 0; i < PER_REQUEST; i++)
+            specs[i] = FlatCarBuilder().setEngine(engines[i % 2]).setColor(colors[i % 2]).addGPS();
+        std::size_t bytes = 0;
+        for (FlatCar car : FlatCarBuilder::buildAll(specs, PER_REQUEST, arena))
+            bytes += car.engine().size() + car.color().size();
+        return bytes;
+    });
+}
+
 /* =========================================================
    Client code – chooses either the fluent builder directly
    or one of the Director’s predefined recipes.
@@ -120,4 +338,26 @@ int main() {
     // 2️⃣  Get a ready-made “Sports Car” via Director
     auto sports = CarDirector::makeSportsCar();
     sports->specs();
+    std::cout << '\n';
+
+    // 3️⃣  Same steps, flat records in an arena on the stack
+    alignas(8) char buffer[4096];
+    std::pmr::monotonic_buffer_resource arena(buffer, sizeof buffer, std::pmr::null_memory_resource());
+    FlatCar flat = FlatCarBuilder()
+                    .setEngine("Electric")
+                    .setColor ("Midnight Black")
+                    .addGPS()
+                    .build(arena);
+    flat.specs();
+
+    std::vector<FlatCarBuilder> fleet = {
+        FlatCarBuilder().setEngine("V8").setColor("Red").addGPS().addAudio(),
+        FlatCarBuilder().setEngine("Inline-4").setColor("White"),
+        FlatCarBuilder().setEngine("Hybrid").setColor("Silver").addAudio(),
+    };
+    std::cout << "\nFleet, built in one pass:\n";
+    for (FlatCar car : FlatCarBuilder::buildAll(fleet, arena))
+        std::cout << "  " << car.engine() << ", " << car.color() << " (" << car.size() << " bytes)\n";
+
+    benchmark();
 }
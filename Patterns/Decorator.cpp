@@ -9,11 +9,23 @@
         – GUI: adding scrollbars, borders, shadows to a widget
         – I/O streams: buffering, compression, encryption layers
         – Logging / metrics: wrap a service call with tracing
+  • Two flavours below
+        – Runtime stacking (sections 1-5): any layers in any order, chosen
+          while the program runs; one virtual call per layer
+        – Compile-time stacking (section 6): the layers are template
+          mixins, so the whole stack is one type and the compiler inlines
+          it into a single flat call
  ----------------------------------------------------------------------------
 */
 
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
 #include <iostream>
+#include <new>
 #include <string>
+#include <type_traits>
+#include <utility>
 
 /* =========================================================
    1. Component – the common interface that both core
@@ -21,9 +33,16 @@
    ---------------------------------------------------------*/
 class Beverage {
 public:
-    virtual std::string description() const = 0;
+    // Appends to `out`, so a stack of N layers builds one string, not N
+    virtual void        describe(std::string& out) const = 0;
     virtual double      cost()        const = 0;
     virtual ~Beverage() = default;
+
+    std::string description() const {
+        std::string s;
+        describe(s);
+        return s;
+    }
 };
 
 /* =========================================================
@@ -31,7 +50,7 @@ public:
    ---------------------------------------------------------*/
 class Espresso : public Beverage {
 public:
-    std::string description() const override { return "Espresso"; }
+    void        describe(std::string& out) const override { out += "Espresso"; }
     double      cost()        const override { return 110.0; } // ₹
 };
 
@@ -45,7 +64,7 @@ protected:
 public:
     explicit AddOnDecorator(Beverage* b) : wrapped(b) {}
     // Default forwarding (may be overridden)
-    std::string description() const override { return wrapped->description(); }
+    void        describe(std::string& out) const override { wrapped->describe(out); }
     double      cost()        const override { return wrapped->cost(); }
 };
 
@@ -55,17 +74,194 @@ public:
 class Milk : public AddOnDecorator {
 public:
     explicit Milk(Beverage* b) : AddOnDecorator(b) {}
-    std::string description() const override { return wrapped->description() + ", Milk"; }
+    void        describe(std::string& out) const override { wrapped->describe(out); out += ", Milk"; }
     double      cost()        const override { return wrapped->cost() + 15.0; }
 };
 
 class Mocha : public AddOnDecorator {
 public:
     explicit Mocha(Beverage* b) : AddOnDecorator(b) {}
-    std::string description() const override { return wrapped->description() + ", Mocha"; }
+    void        describe(std::string& out) const override { wrapped->describe(out); out += ", Mocha"; }
     double      cost()        const override { return wrapped->cost() + 20.0; }
 };
 
+/* =========================================================
+   5. Arena – owns the nodes of runtime stacks.
+      Nodes are bump-allocated side by side in 4 KB blocks
+      (a chain walks memory that is close together, and
+      building one is a pointer bump, not a malloc), and
+      are all destroyed, newest first, with the arena.
+   ---------------------------------------------------------*/
+class BeverageArena {
+    struct Header {                       // In front of every node
+        void  (*destroy)(void*);
+        Header* prev;
+    };
+    struct Block {
+        Block*      prev;
+        std::size_t used;
+    };
+
+    static constexpr std::size_t BLOCK = 4096;
+
+    Block*  blocks = nullptr;
+    Header* newest = nullptr;
+
+    void* allocate(std::size_t size, std::size_t align) {
+        auto fits = [&](Block* b, std::size_t& at) {
+            at = (b->used + align - 1) / align * align;
+            return at + size <= BLOCK;
+        };
+        std::size_t at = 0;
+        if (!blocks || !fits(blocks, at)) {
+            if (sizeof(Block) + size + align > BLOCK)
+                throw std::bad_alloc();
+            Block* b = static_cast<Block*>(::operator new(BLOCK));
+            b->prev = blocks;
+            b->used = sizeof(Block);
+            blocks = b;
+            fits(b, at);
+        }
+        blocks->used = at + size;
+        return reinterpret_cast<char*>(blocks) + at;
+    }
+
+public:
+    BeverageArena() = default;
+    BeverageArena(const BeverageArena&) = delete;
+    BeverageArena& operator=(const BeverageArena&) = delete;
+
+    ~BeverageArena() {
+        for (Header* h = newest; h; h = h->prev)
+            h->destroy(h + 1);
+        while (blocks) {
+            Block* prev = blocks->prev;
+            ::operator delete(blocks);
+            blocks = prev;
+        }
+    }
+
+    template <class T, class... Args>
+    T* make(Args&&... args) {
+        static_assert(std::is_base_of<Beverage, T>::value, "arena holds beverages");
+        static_assert(alignof(T) <= alignof(Header), "node alignment");
+        Header* h = static_cast<Header*>(allocate(sizeof(Header) + sizeof(T), alignof(Header)));
+        T* node = new (h + 1) T(std::forward<Args>(args)...);
+        h->destroy = [](void* p) { static_cast<T*>(p)->~T(); };
+        h->prev = newest;
+        newest = h;
+        return node;
+    }
+};
+
+/* =========================================================
+   6. Compile-time decorators – each layer is a mixin that
+      derives from whatever it decorates and calls it
+      directly (no pointer, no virtual), so a whole stack
+      like MochaOn<MilkOn<EspressoCore>> is one object the
+      size of its core and cost() inlines to a run of adds.
+   ---------------------------------------------------------*/
+struct EspressoCore {
+    double price = 110.0;                 // Runtime data, so nothing constant-folds away
+    void   describe(std::string& out) const { out += "Espresso"; }
+    double cost()                     const { return price; }
+};
+
+template <class Inner>
+struct MilkOn : Inner {
+    void   describe(std::string& out) const { Inner::describe(out); out += ", Milk"; }
+    double cost()                     const { return Inner::cost() + 15.0; }
+};
+
+template <class Inner>
+struct MochaOn : Inner {
+    void   describe(std::string& out) const { Inner::describe(out); out += ", Mocha"; }
+    double cost()                     const { return Inner::cost() + 20.0; }
+};
+
+// Stack<Core, A, B> is B<A<Core>>: layers listed innermost first, like the `new` chain in main()
+template <class Core, template <class> class... Layers>
+struct StackOf;
+
+template <class Core>
+struct StackOf<Core> { using type = Core; };
+
+template <class Core, template <class> class First, template <class> class... Rest>
+struct StackOf<Core, First, Rest...> { using type = typename StackOf<First<Core>, Rest...>::type; };
+
+template <class Core, template <class> class... Layers>
+using Stack = typename StackOf<Core, Layers...>::type;
+
+// Where a stack must cross into runtime code: the whole flattened stack behind one virtual call
+template <class S>
+class StaticBeverage : public Beverage {
+    S stack;
+public:
+    void        describe(std::string& out) const override { stack.describe(out); }
+    double      cost()        const override { return stack.cost(); }
+};
+
+/* =========================================================
+   Benchmark – cost() and describe() per call at stack
+   depths 1-16, layers alternating Milk and Mocha.
+   ---------------------------------------------------------*/
+template <int N>
+struct Alternating {
+    using type = std::conditional_t<N % 2, MilkOn<typename Alternating<N - 1>::type>, MochaOn<typename Alternating<N - 1>::type>>;
+};
+
+template <>
+struct Alternating<0> { using type = EspressoCore; };
+
+volatile double sink;
+
+// The empty asm makes the compiler forget what it knows about `obj` each call, so no call is hoisted out of the loop
+template <class T, class F>
+double nsPerCall(T* obj, F call, long n) {
+    double acc = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < n; i++) {
+        asm volatile("" : "+r"(obj) : : "memory");
+        acc += call(obj);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / n;
+    sink = acc;
+    return ns;
+}
+
+template <int Depth>
+void benchDepth() {
+    const long N = 20'000'000, D = 2'000'000;
+
+    Beverage* nodes[Depth + 1];
+    Beverage* heap = nodes[0] = new Espresso();
+    BeverageArena arena;
+    Beverage* pooled = arena.make<Espresso>();
+    for (int i = 1; i <= Depth; i++) {
+        heap   = nodes[i] = i % 2 ? static_cast<Beverage*>(new Milk(heap)) : new Mocha(heap);
+        pooled = i % 2 ? static_cast<Beverage*>(arena.make<Milk>(pooled)) : arena.make<Mocha>(pooled);
+    }
+    typename Alternating<Depth>::type flat;
+    StaticBeverage<typename Alternating<Depth>::type> boxed;
+
+    std::string buf;
+    auto cost = [](auto* b) { return b->cost(); };
+    auto desc = [&](auto* b) { buf.clear(); b->describe(buf); return (double)buf.size(); };
+
+    std::cout << std::setw(5) << Depth << std::fixed << std::setprecision(2)
+              << std::setw(10) << nsPerCall(heap, cost, N)
+              << std::setw(10) << nsPerCall(pooled, cost, N)
+              << std::setw(10) << nsPerCall(&flat, cost, N)
+              << std::setw(10) << nsPerCall(static_cast<Beverage*>(&boxed), cost, N)
+              << std::setw(12) << nsPerCall(pooled, desc, D)
+              << std::setw(10) << nsPerCall(&flat, desc, D)
+              << std::setw(12) << nsPerCall(heap, [](Beverage* b) { return (double)b->description().size(); }, D)
+              << "\n";
+
+    for (Beverage* b : nodes)
+        delete b;
+}
+
 /* =========================================================
    Client code – stacks decorators using `new`.
    ---------------------------------------------------------*/
@@ -89,4 +285,26 @@ int main() {
        that if you need).  For brevity in this demo:
     -----------------------------------------------------*/
     delete order;   // ❗ In real code prefer smart pointers
+
+    // Same order, nodes owned by an arena: freed together when it goes out of scope
+    {
+        BeverageArena arena;
+        Beverage* pooled = arena.make<Mocha>(arena.make<Milk>(arena.make<Espresso>()));
+        std::cout << pooled->description() << " : ₹" << pooled->cost() << " (arena)\n";
+    }
+
+    // Same order, built at compile time
+    Stack<EspressoCore, MilkOn, MochaOn> flat;
+    std::string s;
+    flat.describe(s);
+    std::cout << s << " : ₹" << flat.cost() << " (compile-time stack, " << sizeof(flat) << " bytes)\n";
+
+    std::cout << "\nns per call; cost() by heap chain, arena chain, template stack, template stack behind one virtual;\n"
+              << "describe() into a reused string by arena chain and template stack; description() returning a new string\n";
+    std::cout << "depth      heap     arena  template     boxed  describe:arena  template  description()\n";
+    benchDepth<1>();
+    benchDepth<2>();
+    benchDepth<4>();
+    benchDepth<8>();
+    benchDepth<16>();
 }
@@ -19,12 +19,27 @@
         2. ConcreteProduct (implementor) – actual objects returned
         3. Creator (interface / base)    – declares factoryMethod()
         4. ConcreteCreator               – overrides factoryMethod()
+  • ShapeFactory (section 5) is the same idea for hot paths: creators are
+    registered under ids hashed from their names at compile time, so the
+    client's if/else becomes one table lookup, and every product type has
+    its own object pool, so creating and releasing a product is a free-list
+    pop and push instead of a malloc and a free.
  ----------------------------------------------------------------------------
 */
 
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
 #include <iostream>
 #include <memory>
+#include <new>
+#include <random>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <vector>
 
 /* =========================================================
    1. Product – an abstract base class (interface).
@@ -49,6 +64,13 @@ public:
     void draw() const override { std::cout << "Drawing a Square\n"; }
 };
 
+class Triangle : public Shape {
+    double a, b, c;
+public:
+    Triangle(double _a=3, double _b=4, double _c=5) : a(_a), b(_b), c(_c) {}
+    void draw() const override { std::cout << "Drawing a Triangle " << a << "-" << b << "-" << c << "\n"; }
+};
+
 /* =========================================================
    3. Creator – declares *factoryMethod()* that returns a
       `Shape`.  It may also provide default (virtual) logic
@@ -88,6 +110,282 @@ public:
     }
 };
 
+/* =========================================================
+   5. Pooled registry factory.
+   ---------------------------------------------------------*/
+
+// FNV-1a: constexpr, so "circle"_id is a constant in the binary
+constexpr std::uint64_t typeId(std::string_view name) {
+    std::uint64_t h = 14695981039346656037ULL;
+    for (char ch : name)
+        h = (h ^ (unsigned char)ch) * 1099511628211ULL;
+    return h;
+}
+
+constexpr std::uint64_t operator""_id(const char* s, std::size_t n) { return typeId(std::string_view(s, n)); }
+
+/*
+    Fixed-size slots for one type, carved out of slabs that
+    double in size; a free slot holds the link to the next.
+    Memory goes back to the system only with the pool.
+*/
+template <class T>
+class ObjectPool {
+    union Slot {
+        Slot* next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    std::vector<std::unique_ptr<Slot[]>> slabs;
+    Slot*       freeList = nullptr;
+    std::size_t nextSlab;
+    std::size_t slots = 0, live = 0;
+
+public:
+    explicit ObjectPool(std::size_t firstSlab = 64) : nextSlab(std::max<std::size_t>(1, firstSlab)) {}
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    // Makes sure `n` more acquires will not allocate
+    void reserve(std::size_t n) {
+        if (slots - live >= n)
+            return;
+        std::size_t size = std::max(nextSlab, n - (slots - live));
+        slabs.emplace_back(new Slot[size]);
+        Slot* slab = slabs.back().get();
+        for (std::size_t i = 0; i < size; i++) {
+            slab[i].next = freeList;
+            freeList = &slab[i];
+        }
+        slots += size;
+        nextSlab = size * 2;
+    }
+
+    template <class... Args>
+    T* acquire(Args&&... args) {
+        if (!freeList)
+            reserve(1);
+        Slot* s = freeList;
+        freeList = s->next;                 // Read before the object overwrites it
+        try {
+            new (s->storage) T(std::forward<Args>(args)...);
+        } catch (...) {
+            freeList = s;
+            throw;
+        }
+        live++;
+        return reinterpret_cast<T*>(s->storage);
+    }
+
+    void release(T* obj) {
+        obj->~T();
+        Slot* s = reinterpret_cast<Slot*>(obj);
+        s->next = freeList;
+        freeList = s;
+        live--;
+    }
+
+    std::size_t capacity() const { return slots; }
+    std::size_t inUse()    const { return live; }
+};
+
+// Deleter of a pooled handle: puts the product back in the pool it came from.
+// A default-constructed one (ShapeHandle h; h.reset(new Circle)) owns a plain heap object.
+struct Recycle {
+    void  (*recycle)(void* pool, Shape* obj) = nullptr;
+    void* pool = nullptr;
+
+    void operator()(Shape* obj) const {
+        if (recycle)
+            recycle(pool, obj);
+        else
+            delete obj;
+    }
+};
+
+using ShapeHandle = std::unique_ptr<Shape, Recycle>;
+
+/*
+    Type ids -> creators, each with its own ObjectPool, in
+    an open-addressed table indexed by the id's low bits.
+    Not thread-safe: give each thread its own factory.
+    Move-only, since a copy would share the pools.
+    Handles must be released before their factory goes.
+*/
+class ShapeFactory {
+    struct Entry {
+        std::uint64_t       id = 0;     // 0: empty
+        std::string         name;
+        std::shared_ptr<void> pool;     // Type-erased owner
+        Shape* (*make)(void* pool) = nullptr;
+        void  (*reserve)(void* pool, std::size_t n) = nullptr;
+        Recycle             recycle;
+    };
+
+    std::vector<Entry> table = std::vector<Entry>(16);
+    std::size_t        count = 0;
+
+    const Entry* find(std::uint64_t id) const {
+        for (std::size_t i = id & (table.size() - 1);; i = (i + 1) & (table.size() - 1)) {
+            if (table[i].id == id)
+                return &table[i];
+            if (table[i].id == 0)
+                return nullptr;
+        }
+    }
+
+    const Entry& lookup(std::uint64_t id) const {
+        const Entry* e = find(id);
+        if (!e)
+            throw std::out_of_range("no shape registered under id " + std::to_string(id));
+        return *e;
+    }
+
+    void insert(Entry e) {
+        if ((count + 1) * 2 > table.size()) {
+            std::vector<Entry> old(table.size() * 2);
+            old.swap(table);
+            count = 0;
+            for (Entry& x : old)
+                if (x.id)
+                    insert(std::move(x));
+        }
+        std::size_t i = e.id & (table.size() - 1);
+        while (table[i].id)
+            i = (i + 1) & (table.size() - 1);
+        table[i] = std::move(e);
+        count++;
+    }
+
+public:
+    ShapeFactory() = default;
+    ShapeFactory(const ShapeFactory&) = delete;
+    ShapeFactory& operator=(const ShapeFactory&) = delete;
+    ShapeFactory(ShapeFactory&&) = default;
+    ShapeFactory& operator=(ShapeFactory&&) = default;
+
+    template <class T>
+    void add(std::string_view name, std::size_t firstSlab = 64) {
+        static_assert(std::is_base_of<Shape, T>::value, "products are Shapes");
+        std::uint64_t id = typeId(name);
+        if (const Entry* e = find(id))
+            throw std::invalid_argument("'" + std::string(name) + "' collides with registered '" + e->name + "'");
+        Entry e;
+        e.id = id;
+        e.name = std::string(name);
+        e.pool = std::make_shared<ObjectPool<T>>(firstSlab);
+        e.make = [](void* p) -> Shape* { return static_cast<ObjectPool<T>*>(p)->acquire(); };
+        e.reserve = [](void* p, std::size_t n) { static_cast<ObjectPool<T>*>(p)->reserve(n); };
+        e.recycle = Recycle{[](void* p, Shape* s) { static_cast<ObjectPool<T>*>(p)->release(static_cast<T*>(s)); }, e.pool.get()};
+        insert(std::move(e));
+    }
+
+    ShapeHandle create(std::uint64_t id) const {
+        const Entry& e = lookup(id);
+        return ShapeHandle(e.make(e.pool.get()), e.recycle);
+    }
+
+    ShapeHandle create(std::string_view name) const { return create(typeId(name)); }
+
+    // One lookup and at most one slab allocation for the lot
+    void createN(std::uint64_t id, std::size_t n, std::vector<ShapeHandle>& out) const {
+        const Entry& e = lookup(id);
+        e.reserve(e.pool.get(), n);
+        out.reserve(out.size() + n);
+        for (std::size_t i = 0; i < n; i++)
+            out.emplace_back(e.make(e.pool.get()), e.recycle);
+    }
+};
+
+/* =========================================================
+   Benchmark – pooled handles against make_unique for
+   three patterns: create and drop at once; churn, where a
+   window of live objects has random members replaced; and
+   bulk creation of 1000 at a time.
+   ---------------------------------------------------------*/
+struct BenchResult {
+    double perSec, p50, p99, p999;          // ns per op, over groups of ops
+};
+
+// Ops are timed in groups of `group`, so the clock reads (~45ns here) do not swamp a 10ns op
+template <class Op>
+BenchResult measure(long n, Op op, int group=64) {
+    std::vector<float> lat(n / group);
+    auto begin = std::chrono::steady_clock::now(), t0 = begin;
+    for (long g = 0; g < (long)lat.size(); g++) {
+        for (long i = g * group; i < (g + 1) * group; i++)
+            op(i);
+        auto t1 = std::chrono::steady_clock::now();
+        lat[g] = std::chrono::duration<float, std::nano>(t1 - t0).count() / group;
+        t0 = t1;
+    }
+    double s = std::chrono::duration<double>(t0 - begin).count();
+    auto at = [&](double q) {
+        std::size_t k = std::min<std::size_t>(lat.size() - 1, (std::size_t)(q * lat.size()));
+        std::nth_element(lat.begin(), lat.begin() + k, lat.end());
+        return (double)lat[k];
+    };
+    return {lat.size() * group / s, at(0.5), at(0.99), at(0.999)};
+}
+
+void report(const char* name, BenchResult r, int perOp=1) {
+    std::cout << "  " << std::left << std::setw(34) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(7) << r.perSec * perOp / 1e6 << " M objects/s   ns/op p50 " << std::setprecision(0) << std::setw(6) << r.p50
+              << ", p99 " << std::setw(6) << r.p99 << ", p99.9 " << std::setw(6) << r.p999 << "\n";
+}
+
+void benchmark() {
+    ShapeFactory factory;
+    factory.add<Circle>("circle");
+    factory.add<Square>("square");
+    factory.add<Triangle>("triangle");
+    const std::uint64_t ids[] = {"circle"_id, "square"_id, "triangle"_id};
+    auto heapMake = [](int kind) -> std::unique_ptr<Shape> {
+        if (kind == 0) return std::make_unique<Circle>();
+        if (kind == 1) return std::make_unique<Square>();
+        return std::make_unique<Triangle>();
+    };
+
+    const long N = 5'000'000;
+    std::cout << "\n--- Create and drop ---\n";
+    report("make_unique", measure(N, [&](long i) { auto p = heapMake(i % 3); asm volatile("" : : "r"(p.get()) : "memory"); }));
+    report("ShapeFactory::create", measure(N, [&](long i) { auto p = factory.create(ids[i % 3]); asm volatile("" : : "r"(p.get()) : "memory"); }));
+
+    const std::size_t WINDOW = 200'000;
+    std::mt19937 rng(1);
+    std::vector<std::uint32_t> picks(N);
+    for (auto& x : picks)
+        x = rng() % WINDOW;
+    std::cout << "\n--- Churn: " << WINDOW << " live objects, a random one replaced per op ---\n";
+    {
+        std::vector<std::unique_ptr<Shape>> live(WINDOW);
+        for (std::size_t i = 0; i < WINDOW; i++)
+            live[i] = heapMake(i % 3);
+        report("make_unique", measure(N, [&](long i) { live[picks[i]] = heapMake(i % 3); }));
+    }
+    {
+        std::vector<ShapeHandle> live;
+        for (std::size_t i = 0; i < WINDOW; i++)
+            live.push_back(factory.create(ids[i % 3]));
+        report("ShapeFactory::create", measure(N, [&](long i) { live[picks[i]] = factory.create(ids[i % 3]); }));
+    }
+
+    const std::size_t BULK = 1000;
+    std::cout << "\n--- Bulk: " << BULK << " at a time (ns per batch) ---\n";
+    std::vector<std::unique_ptr<Shape>> heapBatch;
+    heapBatch.reserve(BULK);
+    report("make_unique x1000", measure(N / BULK, [&](long i) {
+        heapBatch.clear();
+        for (std::size_t k = 0; k < BULK; k++)
+            heapBatch.push_back(heapMake(i % 3));
+    }, 1), BULK);
+    std::vector<ShapeHandle> pooledBatch;
+    report("ShapeFactory::createN(1000)", measure(N / BULK, [&](long i) {
+        pooledBatch.clear();
+        factory.createN(ids[i % 3], BULK, pooledBatch);
+    }, 1), BULK);
+}
+
 /* =========================================================
    Client code – works **only with the Creator interface**.
    It does not know or care which concrete product it gets.
@@ -103,4 +401,18 @@ int main() {
 
     // Draw via the factory-supplied object
     creator->drawShape();
+
+    // Registry: no if/else, and a new shape is one add<>() away
+    ShapeFactory factory;
+    factory.add<Circle>("circle");
+    factory.add<Square>("square");
+    factory.add<Triangle>("triangle");
+    factory.create(choice)->draw();                     // Runtime string: hashed once here
+    factory.create("triangle"_id)->draw();              // Id hashed at compile time
+
+    ShapeHandle plain;                                  // Not from a pool: freed with delete
+    plain.reset(new Square);
+    plain->draw();
+
+    benchmark();
 }
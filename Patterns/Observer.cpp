@@ -10,6 +10,10 @@
 
         Optional:
             - Event : It is the data structure that implements the event & its corresponding payload
+
+    EventBus<Event> below is the same pattern made asynchronous, for when publishers must not wait on
+    their subscribers: typed events go through a bounded queue to a pool of workers, which hand them to
+    the subscribers in batches.
 */
 
 #include <bits/stdc++.h>
@@ -18,12 +22,12 @@ using namespace std;
 
 class ObserverInterface{
     public:
-        virtual void update(string event) = 0; // Enforces that this method is implemented in the child classes
+        virtual void update(const string& event) = 0; // Enforces that this method is implemented in the child classes
 };
 
 class ObserverConcrete : public ObserverInterface{
     public:
-        void update(string event){ // Now has more freedom to implement this however they want
+        void update(const string& event){ // Now has more freedom to implement this however they want
             cout << "Event Recieved : " << event << endl;
         }
 };
@@ -31,7 +35,7 @@ class ObserverConcrete : public ObserverInterface{
 class Publisher{
     unordered_set<ObserverInterface *> st; // Makes it More Extensable
     public:
-        void publish(string event){
+        void publish(const string& event){
             for(auto x : st)
                 x->update(event);
         }
@@ -45,6 +49,416 @@ class Publisher{
         }
 };
 
+/*
+    Bounded multi-producer multi-consumer ring (Dmitry Vyukov's): each cell carries a sequence number
+    saying whether it is ready for the producer or the consumer of the current lap, so producers only
+    contend on `head`, consumers only on `tail`, and nobody takes a lock.
+*/
+template<class T>
+class BoundedQueue{
+        struct Cell{
+            atomic<size_t>  seq;
+            T               value;
+        };
+
+        unique_ptr<Cell[]>  cells;
+        size_t              mask;
+        alignas(64) atomic<size_t> head{0};        // Next slot to fill
+        alignas(64) atomic<size_t> tail{0};        // Next slot to drain
+
+    public:
+        explicit BoundedQueue(size_t capacity){
+            size_t n = 2;
+            while(n < capacity)
+                n *= 2;
+            cells.reset(new Cell[n]);
+            mask = n - 1;
+            for(size_t i = 0; i < n; i++)
+                cells[i].seq.store(i, memory_order_relaxed);
+        }
+
+        // Leaves `value` untouched when the queue is full
+        bool tryPush(T& value){
+            size_t pos = head.load(memory_order_relaxed);
+            for(;;){
+                Cell& c = cells[pos & mask];
+                intptr_t diff = (intptr_t)c.seq.load(memory_order_acquire) - (intptr_t)pos;
+                if(diff == 0){
+                    if(head.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)){
+                        c.value = std::move(value);
+                        c.seq.store(pos + 1, memory_order_release);
+                        return true;
+                    }
+                } else if(diff < 0)
+                    return false;
+                else
+                    pos = head.load(memory_order_relaxed);
+            }
+        }
+
+        bool tryPop(T& out){
+            size_t pos = tail.load(memory_order_relaxed);
+            for(;;){
+                Cell& c = cells[pos & mask];
+                intptr_t diff = (intptr_t)c.seq.load(memory_order_acquire) - (intptr_t)(pos + 1);
+                if(diff == 0){
+                    if(tail.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)){
+                        out = std::move(c.value);
+                        c.seq.store(pos + mask + 1, memory_order_release);
+                        return true;
+                    }
+                } else if(diff < 0)
+                    return false;
+                else
+                    pos = tail.load(memory_order_relaxed);
+            }
+        }
+
+        bool empty() const { return head.load() == tail.load(); }
+        size_t capacity() const { return mask + 1; }
+};
+
+/*
+    Asynchronous publish/subscribe for one event type.
+        - publish() moves the event into a bounded queue and returns; every subscriber later gets a
+          const reference to that one copy
+        - Workers pop up to `batch` events at a time and run each subscriber over the whole batch,
+          so the subscriber list is read once per batch, not once per event
+        - The subscriber list is copy-on-write: (un)subscribing swaps in a new list and never blocks a
+          publish. unsubscribe() returns once no worker is still dispatching from an older list, so
+          the handler is never called after that (except from inside the handler itself)
+        - Back-pressure: when subscribers fall behind and the queue fills, publish() waits for room
+          (tryPublish() refuses instead), so memory stays bounded and producers run at the pace of
+          the slowest subscriber
+    With several workers a handler may run on several threads at once and batches can overtake each
+    other; with workers = 1 each subscriber sees events in the order they were queued. Event must be
+    default-constructible and movable.
+*/
+template<class Event>
+class EventBus{
+    public:
+        using Handler = function<void(const Event&)>;
+        using SubscriptionId = uint64_t;
+
+        struct Config{
+            size_t      capacity = 1 << 14;
+            unsigned    workers = max(1u, thread::hardware_concurrency());
+            size_t      batch = 64;
+        };
+
+        struct Stats{
+            long    dispatched{0};          // Events taken off the queue
+            long    deliveries{0};          // Handler calls
+            long    stalls{0};              // Publishes that had to wait for room
+        };
+
+    private:
+        struct Subscriber{
+            SubscriptionId  id;
+            Handler         fn;
+        };
+
+        struct Snapshot{
+            uint64_t            version;
+            vector<Subscriber>  subs;
+        };
+
+        static constexpr uint64_t UNPINNED = UINT64_MAX;  // Busy, but not yet holding a snapshot
+
+        struct alignas(64) Worker{
+            atomic<uint64_t>    pinned{0};      // Version of the list being dispatched; 0 when idle
+            atomic<long>        dispatched{0}, deliveries{0};
+            thread              th;
+        };
+
+        Config                      cfg;
+        BoundedQueue<Event>         queue;
+        shared_ptr<const Snapshot>  subs;       // Only through atomic_load / atomic_store
+        mutex                       writeLock;  // Serialises (un)subscribers
+        SubscriptionId              nextId{1};
+        unique_ptr<Worker[]>        workers;
+
+        mutex                       sleepLock;
+        condition_variable          notEmpty, notFull;
+        atomic<int>                 idle{0}, blocked{0};
+        atomic<long>                stalls{0};
+        atomic<bool>                stopping{false};
+
+        static inline thread_local const EventBus *dispatching = nullptr;
+
+        // Holds a list no older than the newest one published before the pin became visible
+        shared_ptr<const Snapshot> pin(Worker& w){
+            shared_ptr<const Snapshot> s = atomic_load(&subs);
+            for(;;){
+                w.pinned.store(s->version);
+                shared_ptr<const Snapshot> again = atomic_load(&subs);
+                if(again == s)
+                    return s;
+                s = std::move(again);
+            }
+        }
+
+        void wakeWorker(){
+            if(idle.load() > 0){
+                { lock_guard<mutex> lk(sleepLock); }
+                notEmpty.notify_one();
+            }
+        }
+
+        void work(Worker& w){
+            dispatching = this;
+            vector<Event> batch;
+            batch.reserve(cfg.batch);
+            Event e;
+            for(;;){
+                w.pinned.store(UNPINNED);
+                while(batch.size() < cfg.batch && queue.tryPop(e))
+                    batch.push_back(std::move(e));
+
+                if(batch.empty()){
+                    w.pinned.store(0);
+                    if(stopping.load())
+                        break;
+                    unique_lock<mutex> lk(sleepLock);
+                    idle++;
+                    notEmpty.wait_for(lk, chrono::milliseconds(100), [&]{ return !queue.empty() || stopping.load(); });
+                    idle--;
+                    continue;
+                }
+                if(blocked.load() > 0){
+                    { lock_guard<mutex> lk(sleepLock); }
+                    notFull.notify_all();
+                }
+
+                shared_ptr<const Snapshot> s = pin(w);
+                for(const Subscriber& sub : s->subs)
+                    for(const Event& ev : batch)
+                        sub.fn(ev);
+                w.pinned.store(0);
+
+                w.dispatched.store(w.dispatched.load(memory_order_relaxed) + batch.size(), memory_order_relaxed);
+                w.deliveries.store(w.deliveries.load(memory_order_relaxed) + batch.size() * s->subs.size(), memory_order_relaxed);
+                batch.clear();
+            }
+            dispatching = nullptr;
+        }
+
+        void replace(vector<Subscriber> list){
+            auto s = make_shared<Snapshot>();
+            s->version = atomic_load(&subs)->version + 1;
+            s->subs = std::move(list);
+            atomic_store(&subs, shared_ptr<const Snapshot>(std::move(s)));
+        }
+
+    public:
+        explicit EventBus(Config _cfg) : cfg(_cfg), queue(_cfg.capacity), subs(make_shared<Snapshot>(Snapshot{1, {}})) {
+            if(cfg.workers < 1 || cfg.batch < 1)
+                throw invalid_argument("need at least one worker and a batch of one");
+            workers.reset(new Worker[cfg.workers]);
+            for(unsigned i = 0; i < cfg.workers; i++)
+                workers[i].th = thread(&EventBus::work, this, ref(workers[i]));
+        }
+
+        // Delivers what is already queued, then stops the workers
+        ~EventBus(){
+            stopping = true;
+            { lock_guard<mutex> lk(sleepLock); }
+            notEmpty.notify_all();
+            for(unsigned i = 0; i < cfg.workers; i++)
+                workers[i].th.join();
+        }
+
+        EventBus(const EventBus&) = delete;
+        EventBus& operator=(const EventBus&) = delete;
+
+        SubscriptionId subscribe(Handler fn){
+            lock_guard<mutex> lk(writeLock);
+            vector<Subscriber> list = atomic_load(&subs)->subs;
+            list.push_back({nextId, std::move(fn)});
+            replace(std::move(list));
+            return nextId++;
+        }
+
+        // After this returns the handler is not running and will not run again
+        bool unsubscribe(SubscriptionId id){
+            uint64_t version;
+            {
+                lock_guard<mutex> lk(writeLock);
+                vector<Subscriber> list = atomic_load(&subs)->subs;
+                auto it = find_if(list.begin(), list.end(), [&](const Subscriber& s){ return s.id == id; });
+                if(it == list.end())
+                    return false;
+                list.erase(it);
+                replace(std::move(list));
+                version = atomic_load(&subs)->version;
+            }
+            // From inside a handler, waiting on our own worker would never end
+            for(unsigned i = 0; i < cfg.workers; i++)
+                if(dispatching != this || workers[i].th.get_id() != this_thread::get_id())
+                    for(uint64_t p; (p = workers[i].pinned.load()) != 0 && p < version; )
+                        this_thread::yield();
+            return true;
+        }
+
+        bool tryPublish(Event& event){
+            if(!queue.tryPush(event))
+                return false;
+            wakeWorker();
+            return true;
+        }
+
+        // Waits while the queue is full
+        void publish(Event event){
+            for(int spin = 0; !queue.tryPush(event); spin++){
+                if(spin < 16){
+                    this_thread::yield();
+                    continue;
+                }
+                if(spin == 16)
+                    stalls++;
+                unique_lock<mutex> lk(sleepLock);
+                blocked++;
+                notFull.wait_for(lk, chrono::milliseconds(1));
+                blocked--;
+            }
+            wakeWorker();
+        }
+
+        // Waits until everything published so far has been delivered
+        void drain(){
+            for(;;){
+                bool busy = !queue.empty();
+                for(unsigned i = 0; i < cfg.workers && !busy; i++)
+                    busy = workers[i].pinned.load() != 0;
+                if(!busy)
+                    return;
+                this_thread::yield();
+            }
+        }
+
+        Stats stats() const {
+            Stats st;
+            for(unsigned i = 0; i < cfg.workers; i++){
+                st.dispatched += workers[i].dispatched.load(memory_order_relaxed);
+                st.deliveries += workers[i].deliveries.load(memory_order_relaxed);
+            }
+            st.stalls = stalls.load(memory_order_relaxed);
+            return st;
+        }
+
+        size_t queueCapacity() const { return queue.capacity(); }
+};
+
+struct OrderEvent{
+    long    id{0};
+    double  amount{0};
+    string  symbol;             // Longer than the small-string buffer, so a copy would allocate
+};
+
+class CountingObserver : public ObserverInterface{
+    public:
+        long seen = 0;
+        void update(const string& event){
+            seen += event.size();
+        }
+};
+
+struct alignas(64) Counter{
+    atomic<long> n{0};
+};
+
+void BusBenchmark(){
+    const long DELIVERIES = 20'000'000;
+    const string symbol = "EXCHANGE:INSTRUMENT-0000000001";
+    unsigned publishers = 2;
+
+    cout << "\n--- Events/sec by subscriber count (" << publishers << " publisher threads) ---\n";
+    cout << setw(6) << "subs" << setw(18) << "sync Publisher" << setw(16) << "EventBus" << setw(16) << "deliveries/s\n";
+    for(int n : {1, 10, 100, 1000}){
+        long events = max(20'000L, DELIVERIES / n);
+
+        Publisher pb;
+        vector<CountingObserver> observers(n);
+        for(auto& o : observers)
+            pb.addObserver(&o);
+        auto start = chrono::steady_clock::now();
+        for(long i = 0; i < events; i++)
+            pb.publish(symbol);
+        double syncSec = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        EventBus<OrderEvent> bus(EventBus<OrderEvent>::Config{});
+        vector<Counter> counts(n);
+        for(int s = 0; s < n; s++)
+            bus.subscribe([&c = counts[s]](const OrderEvent& e){ c.n.fetch_add(e.id & 1, memory_order_relaxed); });
+        start = chrono::steady_clock::now();
+        vector<thread> pool;
+        for(unsigned p = 0; p < publishers; p++)
+            pool.emplace_back([&, p]{
+                for(long i = p; i < events; i += publishers)
+                    bus.publish(OrderEvent{i, 1.5, symbol});
+            });
+        for(auto& th : pool)
+            th.join();
+        bus.drain();
+        double busSec = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        auto st = bus.stats();
+
+        cout << setw(6) << n << fixed << setprecision(0) << setw(18) << events / syncSec << setw(16) << events / busSec
+             << setw(15) << st.deliveries / busSec << "\n";
+    }
+}
+
+void BackPressureDemo(){
+    cout << "\n--- Back-pressure: one subscriber at 20us/event, queue of 256 ---\n";
+    EventBus<OrderEvent>::Config cfg;
+    cfg.capacity = 256;
+    cfg.workers = 1;
+    EventBus<OrderEvent> bus(cfg);
+    atomic<long> fast{0};
+    bus.subscribe([&](const OrderEvent&){ fast++; });
+    bus.subscribe([](const OrderEvent&){ this_thread::sleep_for(chrono::microseconds(20)); });
+
+    const long N = 5000;
+    auto start = chrono::steady_clock::now();
+    for(long i = 0; i < N; i++)
+        bus.publish(OrderEvent{i, 0, "slow"});
+    double publishSec = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    bus.drain();
+    double totalSec = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << N << " publishes took " << fixed << setprecision(3) << publishSec << "s (queue never held more than " << bus.queueCapacity()
+         << "), all delivered after " << totalSec << "s; " << bus.stats().stalls << " publishes waited for room\n";
+}
+
+void ChurnDemo(){
+    cout << "\n--- Subscribing and unsubscribing while publishing ---\n";
+    EventBus<OrderEvent>::Config cfg;
+    cfg.batch = 16;
+    EventBus<OrderEvent> bus(cfg);
+    atomic<bool> done{false};
+    atomic<long> late{0}, calls{0};
+
+    thread publisher([&]{
+        for(long i = 0; !done; i++)
+            bus.publish(OrderEvent{i, 0, "churn"});
+    });
+    const int ROUNDS = 2000;
+    for(int r = 0; r < ROUNDS; r++){
+        auto gone = make_shared<atomic<bool>>(false);
+        auto id = bus.subscribe([&, gone](const OrderEvent&){
+            calls++;
+            if(*gone)
+                late++;
+        });
+        this_thread::yield();
+        bus.unsubscribe(id);
+        *gone = true;               // Any call after this point would be a bug
+    }
+    done = true;
+    publisher.join();
+    bus.drain();
+    cout << ROUNDS << " subscribe/unsubscribe rounds during publishing: " << calls << " handler calls, " << late << " after unsubscribe returned\n";
+}
+
 int main(){
     Publisher pb = Publisher();
     ObserverConcrete *obs1 = new ObserverConcrete();
@@ -57,4 +471,8 @@ int main(){
     pb.rmvObserver(obs2);
 
     pb.publish("Event 2");
-}
\ No newline at end of file
+
+    BusBenchmark();
+    BackPressureDemo();
+    ChurnDemo();
+}
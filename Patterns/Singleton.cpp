@@ -11,7 +11,21 @@
 * Author: Kevin Browne @ https://portfoliocourses.com
 *
 *******************************************************************************/
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <typeindex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 using namespace std;
 
@@ -28,8 +42,10 @@ protected:
   
 public:
   
-  // We'll give our Singleton object a member variable to help test it out
-  int data;
+  // We'll give our Singleton object a member variable to help test it out.  It
+  // is atomic because every thread shares the one instance: a plain int here 
+  // would be a data race as soon as two threads write it.
+  atomic<int> data{0};
   
   // The static member function get_instance will be responsible for creating 
   // and allowing access to the one Singleton object instance.  Being a static 
@@ -79,6 +95,334 @@ public:
   
 };
 
+// ServiceRegistry: a process-wide home for shared components (caches, pools,
+// metrics) that replaces one ad-hoc Singleton per component.
+//
+//   - Services are registered with the services they depend on, e.g.
+//     provide<Cache, Metrics>() means "a Cache is constructed from a
+//     Metrics&".  start() constructs them all in dependency order (and
+//     rejects cycles and missing dependencies); stop() destroys them in the
+//     reverse order, so nothing outlives what it uses.
+//
+//   - get<T>() is the hot path.  Each thread keeps its own table of pointers
+//     to the instances, indexed by a small per-type number fixed before
+//     main() runs, so a lookup is one thread-local load and a null check.
+//     stop() empties every thread's table, so a non-null slot is always
+//     current.  There is no guard variable, lock or shared read on the way.
+//
+//   - Every instance gets cache lines of its own, so two services written by
+//     different threads never share a line (false sharing).
+//
+// register and start/stop from one thread while nothing calls get(); get()
+// is safe from any number of threads while the registry is started.
+class ServiceRegistry
+{
+public:
+  static constexpr size_t MAX_SERVICES = 64;
+
+private:
+  // Each service type's slot number, handed out during static initialization.
+  // Unlike a function-local static, reading it later involves no guard check.
+  static inline atomic<size_t> types{0};
+
+  template <class T>
+  struct Slot
+  {
+    static inline const size_t index = types++;
+  };
+
+  // Instance storage rounded up to whole cache lines
+  template <class T>
+  struct alignas(64) Padded
+  {
+    T value;
+
+    template <class... Args>
+    explicit Padded(Args&... args) : value(args...) {}
+  };
+
+  struct Entry
+  {
+    string name;
+    size_t index;
+    vector<size_t> deps;                        // Slot numbers
+    void* (*create)(void* const* instances);    // Returns the Padded<T>*
+    void (*destroy)(void*);
+    void* (*object)(void*);                     // Padded<T>* -> T*
+  };
+
+  static inline vector<Entry> entries;
+  static inline vector<size_t> order;           // Entry positions, in start order
+  static inline void* storage[MAX_SERVICES];    // Padded<T>* by slot
+  static inline void* instances[MAX_SERVICES];  // T* by slot, what get() hands out
+
+  // Bumped by every start() and stop().  Odd while started.
+  static inline atomic<uint64_t> epoch{0};
+
+  // Zero-initialized like every thread_local, so a new thread starts empty.
+  // Kept trivial: a constructor or destructor would add an init check to
+  // every access.
+  struct alignas(64) LocalTable
+  {
+    void* slot[MAX_SERVICES];
+  };
+  static inline thread_local LocalTable cache;
+
+  // Every thread's table that has been filled, so stop() can empty them.  A
+  // thread takes its own out again when it exits.
+  static inline mutex tablesLock;
+  static inline unordered_set<LocalTable*> tables;
+
+  struct Enrolment
+  {
+    bool enrolled;      // Zero-initialized, as a thread_local
+    ~Enrolment()
+    {
+      lock_guard<mutex> lock(tablesLock);
+      tables.erase(&cache);
+    }
+  };
+  static inline thread_local Enrolment enrolment;
+
+  template <class T>
+  static T& refresh()
+  {
+    if (!(epoch.load(memory_order_acquire) & 1))
+      throw logic_error("service registry is not started");
+    if (!enrolment.enrolled)
+    {
+      lock_guard<mutex> lock(tablesLock);
+      tables.insert(&cache);
+      enrolment.enrolled = true;
+    }
+    // Asking for a type nobody provided still numbers it, possibly past the table
+    size_t index = Slot<T>::index;
+    if (index >= MAX_SERVICES)
+      throw logic_error("no service registered for this type");
+    copy(begin(instances), end(instances), begin(cache.slot));
+    if (!cache.slot[index])
+      throw logic_error("no service registered for this type");
+    return *static_cast<T*>(cache.slot[index]);
+  }
+
+  template <class T, class... Deps>
+  static void* construct([[maybe_unused]] void* const* ready)
+  {
+    return new Padded<T>(*static_cast<Deps*>(ready[Slot<Deps>::index])...);
+  }
+
+public:
+  // T is constructed as T(Deps&...) by start()
+  template <class T, class... Deps>
+  static void provide(const string& name)
+  {
+    if (epoch.load() & 1)
+      throw logic_error("register services before start()");
+    size_t index = Slot<T>::index;
+    if (index >= MAX_SERVICES)
+      throw length_error("more than " + to_string(MAX_SERVICES) + " service types");
+    for (const Entry& e : entries)
+      if (e.index == index)
+        throw invalid_argument(name + " is already registered as " + e.name);
+    entries.push_back(Entry{name, index, {Slot<Deps>::index...}, &construct<T, Deps...>,
+                            [](void* p) { delete static_cast<Padded<T>*>(p); },
+                            [](void* p) -> void* { return &static_cast<Padded<T>*>(p)->value; }});
+  }
+
+  // Constructs every service, each after all of its dependencies
+  static void start()
+  {
+    if (epoch.load() & 1)
+      throw logic_error("already started");
+
+    // Kahn's algorithm over the dependency edges
+    vector<int> pending(entries.size());
+    vector<vector<size_t>> users(MAX_SERVICES);
+    vector<bool> known(MAX_SERVICES, false);
+    for (const Entry& e : entries)
+      known[e.index] = true;
+    for (size_t i = 0; i < entries.size(); i++)
+      for (size_t d : entries[i].deps)
+      {
+        if (d >= MAX_SERVICES || !known[d])
+          throw logic_error(entries[i].name + " depends on a service that is not registered");
+        users[d].push_back(i);
+        pending[i]++;
+      }
+    order.clear();
+    for (size_t i = 0; i < entries.size(); i++)
+      if (!pending[i])
+        order.push_back(i);
+    for (size_t k = 0; k < order.size(); k++)
+      for (size_t u : users[entries[order[k]].index])
+        if (!--pending[u])
+          order.push_back(u);
+    if (order.size() != entries.size())
+    {
+      string cycle;
+      for (size_t i = 0; i < entries.size(); i++)
+        if (pending[i])
+          cycle += " " + entries[i].name;
+      throw logic_error("dependency cycle among:" + cycle);
+    }
+
+    size_t built = 0;
+    try
+    {
+      for (; built < order.size(); built++)
+      {
+        const Entry& e = entries[order[built]];
+        storage[e.index] = e.create(instances);
+        instances[e.index] = e.object(storage[e.index]);
+      }
+    }
+    catch (...)
+    {
+      // Unwind what was built, newest first, and leave the registry stopped
+      while (built--)
+        release(entries[order[built]]);
+      throw;
+    }
+    epoch.fetch_add(1, memory_order_release);
+  }
+
+  // Destroys the services in the reverse of the order start() built them
+  static void stop()
+  {
+    if (!(epoch.load() & 1))
+      return;
+    epoch.fetch_add(1, memory_order_release);
+    {
+      lock_guard<mutex> lock(tablesLock);
+      for (LocalTable* t : tables)
+        fill(begin(t->slot), end(t->slot), nullptr);
+    }
+    for (size_t k = order.size(); k--; )
+      release(entries[order[k]]);
+  }
+
+  // The hot path: one thread-local slot, a plain load
+  template <class T>
+  static T& get()
+  {
+    size_t index = Slot<T>::index;
+    if (index < MAX_SERVICES)
+      if (void* p = cache.slot[index])
+        return *static_cast<T*>(p);
+    return refresh<T>();
+  }
+
+  // The names of the services, in start order
+  static vector<string> startOrder()
+  {
+    vector<string> names;
+    for (size_t i : order)
+      names.push_back(entries[i].name);
+    return names;
+  }
+
+private:
+  static void release(const Entry& e)
+  {
+    instances[e.index] = nullptr;
+    e.destroy(storage[e.index]);
+    storage[e.index] = nullptr;
+  }
+};
+
+// A few shared components with dependencies between them, to try it out.  
+// Each one's constructor and destructor print, so the order is visible.
+struct Metrics
+{
+  atomic<long> lookups{0};
+  Metrics() { cout << "  + Metrics\n"; }
+  ~Metrics() { cout << "  - Metrics\n"; }
+};
+
+struct ConnectionPool
+{
+  Metrics& metrics;
+  int size = 16;
+  explicit ConnectionPool(Metrics& m) : metrics(m) { cout << "  + ConnectionPool (uses Metrics)\n"; }
+  ~ConnectionPool() { cout << "  - ConnectionPool\n"; }
+};
+
+struct Cache
+{
+  Metrics& metrics;
+  ConnectionPool& pool;
+  long entries = 1000;
+  Cache(Metrics& m, ConnectionPool& p) : metrics(m), pool(p) { cout << "  + Cache (uses Metrics, ConnectionPool)\n"; }
+  ~Cache() { cout << "  - Cache\n"; }
+};
+
+// The usual alternative to compare with: one map of services behind a mutex
+class LockedRegistry
+{
+  mutex m;
+  unordered_map<type_index, void*> services;
+
+public:
+  template <class T>
+  void add(T* service)
+  {
+    lock_guard<mutex> lock(m);
+    services[type_index(typeid(T))] = service;
+  }
+
+  template <class T>
+  T& get()
+  {
+    lock_guard<mutex> lock(m);
+    return *static_cast<T*>(services.at(type_index(typeid(T))));
+  }
+};
+
+// Nanoseconds per lookup with `threads` threads each doing `n` of them.  The
+// empty asm stops the compiler from doing the lookup once outside the loop.
+template <class Lookup>
+double nsPerLookup(unsigned threads, long n, Lookup lookup)
+{
+  vector<thread> pool;
+  atomic<long> sink{0};
+  auto start = chrono::steady_clock::now();
+  for (unsigned t = 0; t < threads; t++)
+    pool.emplace_back([&]
+    {
+      long sum = 0;
+      for (long i = 0; i < n; i++)
+      {
+        asm volatile("" ::: "memory");
+        sum += lookup();
+      }
+      sink += sum;
+    });
+  for (auto& th : pool)
+    th.join();
+  // Total CPU time spent, per lookup: fair whether or not there are 32 cores
+  double wall = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+  unsigned cores = max(1u, min(threads, thread::hardware_concurrency()));
+  return wall * cores / ((double)n * threads);
+}
+
+void benchmark()
+{
+  const unsigned THREADS = 32;
+  const long N = 5'000'000;
+  Metrics metrics;
+  LockedRegistry locked;
+  locked.add(&metrics);
+
+  cout << "\n--- Lookup cost, " << THREADS << " threads x " << N << " lookups (ns of CPU per lookup) ---\n";
+  cout << fixed << setprecision(2);
+  cout << "  Singleton::get_instance() (static guard) : " 
+       << nsPerLookup(THREADS, N, [] { return (long)Singleton::get_instance().data.load(memory_order_relaxed); }) << "\n";
+  cout << "  ServiceRegistry::get<Cache>()             : "
+       << nsPerLookup(THREADS, N, [] { return ServiceRegistry::get<Cache>().entries; }) << "\n";
+  cout << "  LockedRegistry::get<Metrics>() (mutex)     : "
+       << nsPerLookup(THREADS, N / 10, [&] { return (long)locked.get<Metrics>().lookups.load(memory_order_relaxed); }) << "\n";
+}
+
 int main()
 {
   // Because the Singleton constructor is protected, attempting to instantiate
@@ -148,6 +492,42 @@ int main()
   // singletonN.data = 100;
   // cout << "singleton1.data = " << singleton1.data << endl;
   // cout << "singletonN.data = " << singletonN.data << endl;
-  
+
+  // With many shared components, a registry with explicit dependencies 
+  // replaces one Singleton each.  Registration order does not matter: 
+  // start() works out the order from the dependencies.
+  ServiceRegistry::provide<Cache, Metrics, ConnectionPool>("Cache");
+  ServiceRegistry::provide<ConnectionPool, Metrics>("ConnectionPool");
+  ServiceRegistry::provide<Metrics>("Metrics");
+
+  cout << "\nstart():\n";
+  ServiceRegistry::start();
+  Cache& cache = ServiceRegistry::get<Cache>();
+  cout << "Cache has " << cache.entries << " entries, its pool " << cache.pool.size << " connections; same pool via the registry: "
+       << (&cache.pool == &ServiceRegistry::get<ConnectionPool>() ? "yes" : "no") << "\n";
+  cout << "each instance on its own cache line: "
+       << ((uintptr_t)&ServiceRegistry::get<Metrics>() % 64 == 0 && (uintptr_t)&cache % 64 == 0 ? "yes" : "no") << "\n";
+  try
+  {
+    ServiceRegistry::get<string>();
+  }
+  catch (const logic_error& e)
+  {
+    cout << "get() of a type nobody provided: " << e.what() << "\n";
+  }
+
+  benchmark();
+
+  cout << "\nstop():\n";
+  ServiceRegistry::stop();
+  try
+  {
+    ServiceRegistry::get<Cache>();
+  }
+  catch (const logic_error& e)
+  {
+    cout << "get() after stop(): " << e.what() << "\n";
+  }
+
   return 0;
 }
\ No newline at end of file
@@ -15,12 +15,81 @@
         2. ConcreteStrategy              – each implements the API
         3. Context                       – owns a Strategy pointer and
                                            delegates the work to it
+  • Open vs closed set
+        – PaymentContext takes any PaymentStrategy subclass: one virtual
+          call per payment
+        – BatchPaymentContext only knows the strategies listed in
+          PaymentMethod (a std::variant), so a call is a switch on the
+          variant's index the compiler can inline, and a batch is sorted
+          into one group per method and each group paid in a single pass
  ----------------------------------------------------------------------------
 */
 
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
 #include <iostream>
+#include <limits>
 #include <memory>
+#include <random>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+/* =========================================================
+   0. Output – payments write through a PaymentSink, which
+      formats into one growing buffer and hands it to the
+      stream in large writes, instead of a locked, formatted
+      std::cout insertion per field. Not thread-safe: one
+      sink per thread.
+   ---------------------------------------------------------*/
+class PaymentSink {
+    std::ostream& out;
+    std::string   buf;
+    std::size_t   limit;
+public:
+    explicit PaymentSink(std::ostream& o, std::size_t flushAt = 1 << 16) : out(o), limit(flushAt) {
+        buf.reserve(flushAt + 256);
+    }
+    PaymentSink(const PaymentSink&) = delete;
+    PaymentSink& operator=(const PaymentSink&) = delete;
+    ~PaymentSink() { flush(); }
+
+    PaymentSink& operator<<(std::string_view s) {
+        buf.append(s);
+        if (buf.size() >= limit)
+            flush();
+        return *this;
+    }
+    PaymentSink& operator<<(double v) {                    // Amounts: fixed, two decimals, as on the std::cout path
+        char tmp[std::numeric_limits<double>::max_exponent10 + 8];
+        auto r = std::to_chars(tmp, tmp + sizeof tmp, v, std::chars_format::fixed, 2);
+        return *this << std::string_view(tmp, r.ptr - tmp);
+    }
+    void flush() {
+        out.write(buf.data(), buf.size());
+        buf.clear();
+    }
+};
+
+// std::span stand-in: this file sticks to C++17
+template <class T>
+class Span {
+    T*          ptr;
+    std::size_t len;
+public:
+    Span(T* p, std::size_t n) : ptr(p), len(n) {}
+    template <class C>
+    Span(C& c) : ptr(c.data()), len(c.size()) {}
+    T* data()  const { return ptr; }
+    T* begin() const { return ptr; }
+    T* end()   const { return ptr + len; }
+    std::size_t size() const { return len; }
+    T& operator[](std::size_t i) const { return ptr[i]; }
+};
 
 /* =========================================================
    1. Strategy – the algorithm interface.
@@ -28,36 +97,64 @@
 class PaymentStrategy {
 public:
     virtual void pay(double amount) const = 0;
+    virtual void pay(double amount, PaymentSink& sink) const = 0;
     virtual ~PaymentStrategy() = default;
 };
 
 /* =========================================================
-   2. Concrete Strategies – different algorithms.
+   2. Concrete Strategies – different algorithms. `final`,
+      so a call on the concrete type is a direct call.
+      payAll() pays a whole group, building the part of
+      the line that is the same for every payment once.
    ---------------------------------------------------------*/
-class CreditCardStrategy : public PaymentStrategy {
+class CreditCardStrategy final : public PaymentStrategy {
     std::string cardNumber;
 public:
     explicit CreditCardStrategy(std::string num) : cardNumber(std::move(num)) {}
     void pay(double amount) const override {
-        std::cout << "Paid ₹" << amount << " using Credit Card " << cardNumber << '\n';
+        std::cout << "Paid ₹" << std::fixed << std::setprecision(2) << amount << " using Credit Card " << cardNumber << '\n';
+    }
+    void pay(double amount, PaymentSink& sink) const override {
+        sink << "Paid ₹" << amount << " using Credit Card " << cardNumber << "\n";
+    }
+    void payAll(Span<const double> amounts, PaymentSink& sink) const {
+        std::string tail = " using Credit Card " + cardNumber + "\n";
+        for (double a : amounts)
+            sink << "Paid ₹" << a << tail;
     }
 };
 
-class UPIStrategy : public PaymentStrategy {
+class UPIStrategy final : public PaymentStrategy {
     std::string upiId;
 public:
     explicit UPIStrategy(std::string id) : upiId(std::move(id)) {}
     void pay(double amount) const override {
-        std::cout << "Paid ₹" << amount << " via UPI (" << upiId << ")\n";
+        std::cout << "Paid ₹" << std::fixed << std::setprecision(2) << amount << " via UPI (" << upiId << ")\n";
+    }
+    void pay(double amount, PaymentSink& sink) const override {
+        sink << "Paid ₹" << amount << " via UPI (" << upiId << ")\n";
+    }
+    void payAll(Span<const double> amounts, PaymentSink& sink) const {
+        std::string tail = " via UPI (" + upiId + ")\n";
+        for (double a : amounts)
+            sink << "Paid ₹" << a << tail;
     }
 };
 
-class CryptoStrategy : public PaymentStrategy {
+class CryptoStrategy final : public PaymentStrategy {
     std::string wallet;
 public:
     explicit CryptoStrategy(std::string addr) : wallet(std::move(addr)) {}
     void pay(double amount) const override {
-        std::cout << "Paid ₹" << amount << " with crypto wallet " << wallet << '\n';
+        std::cout << "Paid ₹" << std::fixed << std::setprecision(2) << amount << " with crypto wallet " << wallet << '\n';
+    }
+    void pay(double amount, PaymentSink& sink) const override {
+        sink << "Paid ₹" << amount << " with crypto wallet " << wallet << "\n";
+    }
+    void payAll(Span<const double> amounts, PaymentSink& sink) const {
+        std::string tail = " with crypto wallet " + wallet + "\n";
+        for (double a : amounts)
+            sink << "Paid ₹" << a << tail;
     }
 };
 
@@ -79,8 +176,138 @@ public:
     void checkout(double amount) const {
         strategy->pay(amount);  // delegate to current algorithm
     }
+    void checkout(double amount, PaymentSink& sink) const {
+        strategy->pay(amount, sink);
+    }
 };
 
+/* =========================================================
+   4. Closed-set Context – the strategies it can hold are
+      fixed at compile time, and it keeps a table of
+      configured methods (a card, a UPI id, ...) that
+      payments refer to by index.
+   ---------------------------------------------------------*/
+using PaymentMethod = std::variant<CreditCardStrategy, UPIStrategy, CryptoStrategy>;
+
+struct Payment {
+    std::uint32_t method;                   // Index returned by addMethod()
+    double        amount;
+};
+
+class BatchPaymentContext {
+    std::vector<PaymentMethod> methods;
+    std::vector<std::uint32_t> starts;      // Scratch for checkoutBatch()
+    std::vector<double>        grouped;
+public:
+    std::uint32_t addMethod(PaymentMethod m) {
+        methods.push_back(std::move(m));
+        return methods.size() - 1;
+    }
+
+    void checkout(const Payment& p, PaymentSink& sink) const {
+        std::visit([&](const auto& s) { s.pay(p.amount, sink); }, methods.at(p.method));
+    }
+
+    /*
+        Counting sort by method (two passes over the batch, no
+        comparisons), then one dispatch per method for its whole
+        group. Output comes out grouped by method, in batch order
+        within a group. A bad method index throws before anything
+        is paid.
+    */
+    void checkoutBatch(Span<const Payment> payments, PaymentSink& sink) {
+        starts.assign(methods.size() + 1, 0);
+        for (const Payment& p : payments) {
+            if (p.method >= methods.size())
+                throw std::out_of_range("no payment method " + std::to_string(p.method));
+            starts[p.method + 1]++;
+        }
+        for (std::size_t m = 1; m <= methods.size(); m++)
+            starts[m] += starts[m - 1];
+
+        grouped.resize(payments.size());
+        std::vector<std::uint32_t>& next = starts;          // Fill position per method; ends up shifted one slot down
+        for (const Payment& p : payments)
+            grouped[next[p.method]++] = p.amount;
+
+        for (std::size_t m = 0, from = 0; m < methods.size(); from = next[m++]) {
+            if (next[m] == from)
+                continue;
+            Span<const double> group(grouped.data() + from, next[m] - from);
+            std::visit([&](const auto& s) { s.payAll(group, sink); }, methods[m]);
+        }
+    }
+};
+
+/* =========================================================
+   Benchmark – one large batch of payments spread over a
+   few methods, paid per call through the virtual
+   interface (to std::cout's formatting, and to a sink)
+   and through the variant (per call, and batched).
+   Output goes to a stream that discards it, so only the
+   dispatch and formatting are timed.
+   ---------------------------------------------------------*/
+class NullBuffer : public std::streambuf {
+public:
+    std::size_t bytes = 0;
+protected:
+    std::streamsize xsputn(const char*, std::streamsize n) override { bytes += n; return n; }
+    int overflow(int c) override { bytes++; return c; }
+};
+
+void benchmark() {
+    const std::size_t N = 2'000'000;
+    std::vector<std::unique_ptr<PaymentStrategy>> open;
+    BatchPaymentContext closed;
+    for (int i = 0; i < 4; i++) {
+        std::string n = std::to_string(i);
+        open.push_back(std::make_unique<CreditCardStrategy>("4111-0000-0000-000" + n));
+        open.push_back(std::make_unique<UPIStrategy>("shop" + n + "@upi"));
+        open.push_back(std::make_unique<CryptoStrategy>("0xC0FFEE000" + n));
+        closed.addMethod(CreditCardStrategy("4111-0000-0000-000" + n));
+        closed.addMethod(UPIStrategy("shop" + n + "@upi"));
+        closed.addMethod(CryptoStrategy("0xC0FFEE000" + n));
+    }
+
+    std::mt19937 rng(7);
+    std::vector<Payment> batch(N);
+    for (Payment& p : batch)
+        p = Payment{(std::uint32_t)(rng() % open.size()), (double)(rng() % 1'000'000) / 100};
+
+    NullBuffer nb;
+    std::ostream devnull(&nb);
+    auto run = [&](const char* name, auto body) {
+        nb.bytes = 0;
+        auto start = std::chrono::steady_clock::now();
+        body();
+        double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "  " << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(8) << N / s / 1e6 << " M payments/s  (" << nb.bytes << " bytes)\n";
+    };
+
+    std::cout << "\n--- " << N << " payments over " << open.size() << " methods ---\n";
+    run("virtual pay(), std::cout formatting", [&] {
+        std::streambuf* old = std::cout.rdbuf(&nb);
+        for (const Payment& p : batch)
+            open[p.method]->pay(p.amount);
+        std::cout.rdbuf(old);
+    });
+    run("virtual pay(), PaymentSink", [&] {
+        PaymentSink sink(devnull);
+        for (const Payment& p : batch)
+            open[p.method]->pay(p.amount, sink);
+    });
+    run("variant checkout(), PaymentSink", [&] {
+        PaymentSink sink(devnull);
+        for (const Payment& p : batch)
+            closed.checkout(p, sink);
+    });
+    run("variant checkoutBatch(), PaymentSink", [&] {
+        PaymentSink sink(devnull);
+        closed.checkoutBatch(batch, sink);
+    });
+}
+
 /* =========================================================
    Client code – chooses strategies at runtime.
    ---------------------------------------------------------*/
@@ -93,4 +320,18 @@ int main() {
 
     ctx.setStrategy(std::make_unique<CryptoStrategy>("0xABCDEF4321"));
     ctx.checkout(5000.0);               // pay in crypto
+    ctx.checkout(1234567.89);           // large amounts print the same way on both paths
+
+    // The same payments as one batch through the closed set, via a sink
+    BatchPaymentContext batch;
+    std::uint32_t card = batch.addMethod(CreditCardStrategy("1234-5678-9012-3456"));
+    std::uint32_t upi  = batch.addMethod(UPIStrategy("revanth@upi"));
+    std::uint32_t coin = batch.addMethod(CryptoStrategy("0xABCDEF4321"));
+    std::vector<Payment> payments = {{card, 2500.0}, {upi, 1800.0}, {coin, 5000.0}, {card, 99.5}, {coin, 1234567.89}};
+    {
+        PaymentSink sink(std::cout);
+        batch.checkoutBatch(payments, sink);
+    }
+
+    benchmark();
 }
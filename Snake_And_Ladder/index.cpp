@@ -1,19 +1,991 @@
 #include <bits/stdc++.h>
 #include <random>
 
+#include "../Utils/prng.h"
+
 using namespace std;
 
+/*
+    Snake & Ladder:
+        - Board
+            - Flat move table: (square, roll) -> square after the snake or
+              ladder there, with the exact-finish rule folded in, so a move is
+              one lookup and no branches
+        - GameEngine
+            - Plays whole games for N seats
+            - Runs millions of them across all cores: threads pull chunks of
+              games off a shared counter, each chunk has its own PRNG stream,
+              so results depend only on the seed, not on the thread count
+        - SimulationReport
+            - Game length distribution, win rate by seat, games/sec
+        - MarkovSolver
+            - The same numbers exactly, from the board's absorbing Markov chain
+        - GameServer
+            - Hosts many live games at once: compact per-game records in
+              per-core shards, moves routed to the shard that owns the game,
+              turn timeouts on a timing wheel
+*/
+
+/*
+    Dice for one thread: a PCG32 stream from the shared prng module. Streams of
+    one seed never overlap, so every chunk of games can get its own.
+*/
 class RandomGenerator{
+        prng::Pcg32 rng;
+
     public:
-        RandomGenerator(){
-            srand(time(0));
+        RandomGenerator() : RandomGenerator(random_device{}()) {}
+
+        RandomGenerator(uint64_t seed, uint64_t stream=0) : rng(seed, stream) {}
+
+        void reseed(uint64_t seed, uint64_t stream=0){
+            rng = prng::Pcg32(seed, stream);
         }
 
+        // Uniform in [low, high]
         int getRandom(int low, int high){
-            return (low + rand()%high);
+            return (int)prng::uniform(rng, low, high);
+        }
+};
+
+class Board{
+        int             size;
+        vector<int>     jump;           // Square -> where a token landing there ends up
+        vector<int>     moves;          // (square * 6 + roll - 1) -> next square
+        vector<pair<int, int>> links;   // (from, to) of every snake and ladder
+
+        void rebuild(){
+            moves.assign((size + 1) * 6, 0);
+            for(int sq = 0; sq <= size; sq++)
+                for(int roll = 1; roll <= 6; roll++)
+                    moves[sq * 6 + roll - 1] = sq + roll > size ? sq : jump[sq + roll];     // Overshoot: stay put
+        }
+
+        void link(int from, int to){
+            if(from <= 0 || from >= size || to <= 0 || to > size || from == to)
+                throw invalid_argument("bad snake/ladder " + to_string(from) + "->" + to_string(to));
+            if(jump[from] != from)
+                throw invalid_argument("square " + to_string(from) + " already has a snake or ladder");
+            jump[from] = to;
+            links.push_back({from, to});
+            for(int roll = 1; roll <= 6 && roll <= from; roll++)       // Only moves landing on `from` change
+                moves[(from - roll) * 6 + roll - 1] = to;
+        }
+
+    public:
+        Board(int _size=100) : size(_size), jump(_size + 1) {
+            iota(jump.begin(), jump.end(), 0);
+            rebuild();
+        }
+
+        Board& addSnake(int head, int tail){
+            if(tail >= head)
+                throw invalid_argument("snake must go down");
+            link(head, tail);
+            return *this;
+        }
+
+        Board& addLadder(int bottom, int top){
+            if(top <= bottom)
+                throw invalid_argument("ladder must go up");
+            link(bottom, top);
+            return *this;
+        }
+
+        int move(int square, int roll) const {
+            return moves[square * 6 + roll - 1];
+        }
+
+        int getSize() const { return size; }
+        const vector<pair<int, int>>& getLinks() const { return links; }
+};
+
+struct SimulationReport{
+    long            games{0}, unfinished{0};
+    vector<long>    lengths;            // Rounds -> games that took that many
+    vector<long>    winsBySeat;
+    double          seconds{0};
+    unsigned        threads{0};
+
+    double meanLength() const {
+        double sum = 0;
+        for(size_t r = 0; r < lengths.size(); r++)
+            sum += r * (double)lengths[r];
+        return sum / max(1L, games - unfinished);
+    }
+
+    int percentile(double p) const {
+        long target = (long)(p / 100 * (games - unfinished)), seen = 0;
+        for(size_t r = 0; r < lengths.size(); r++)
+            if((seen += lengths[r]) > target)
+                return r;
+        return lengths.size() - 1;
+    }
+
+    void print() const {
+        cout << games << " games on " << threads << " threads in " << fixed << setprecision(2) << seconds << "s = "
+             << setprecision(0) << games / seconds << " games/sec\n";
+        cout << "rounds: mean " << setprecision(1) << meanLength() << ", p50 " << percentile(50) << ", p90 " << percentile(90)
+             << ", p99 " << percentile(99) << ", p99.9 " << percentile(99.9);
+        if(unfinished)
+            cout << ", " << unfinished << " unfinished";
+        cout << "\n";
+
+        const size_t BIN = 10;
+        auto bin = [&](size_t r){ return accumulate(lengths.begin() + r, lengths.begin() + min(lengths.size(), r + BIN), 0L); };
+        long peak = 1;
+        for(size_t r = 0; r < lengths.size(); r += BIN)
+            peak = max(peak, bin(r));
+        for(size_t r = 0; r < lengths.size() && r <= (size_t)percentile(99.9); r += BIN){
+            long n = bin(r);
+            cout << setw(4) << r << "-" << setw(3) << left << r + BIN - 1 << right << " " << setw(6) << setprecision(2)
+                 << 100.0 * n / games << "% " << string(60 * n / peak, '#') << "\n";
+        }
+
+        cout << "win rate by seat:";
+        for(size_t s = 0; s < winsBySeat.size(); s++)
+            cout << " #" << s + 1 << "=" << setprecision(2) << 100.0 * winsBySeat[s] / games << "%";
+        cout << "\n";
+    }
+};
+
+class GameEngine{
+        const Board &board;
+        int         players;
+        int         maxRounds;                          // Longer games are reported as unfinished
+
+        static constexpr long   CHUNK = 1 << 14;        // Games per unit of work
+
+        // Per-thread tallies, padded so threads never share a cache line
+        struct alignas(64) Tally{
+            vector<long>    lengths;
+            vector<long>    wins;
+            long            unfinished{0};
+        };
+
+    public:
+        GameEngine(const Board& _board, int _players, int _maxRounds=1000) : board(_board), players(_players), maxRounds(_maxRounds) {
+            if(players < 1 || players > 64)
+                throw invalid_argument("need 1 to 64 players");
+        }
+
+        /*
+            Seats take turns from the first; the first token to land exactly
+            on the last square wins. Returns the rounds played and sets winner
+            (-1 if the game hit maxRounds).
+        */
+        int play(RandomGenerator& rng, int& winner) const {
+            int pos[64] = {0};
+            const int last = board.getSize();
+            for(int round = 1; round <= maxRounds; round++)
+                for(int s = 0; s < players; s++)
+                    if((pos[s] = board.move(pos[s], rng.getRandom(1, 6))) == last){
+                        winner = s;
+                        return round;
+                    }
+            winner = -1;
+            return maxRounds;
+        }
+
+        SimulationReport run(long games, unsigned threads=max(1u, thread::hardware_concurrency()), uint64_t seed=1) const {
+            vector<Tally> tallies(threads);
+            atomic<long> nextChunk{0};
+            const long chunks = (games + CHUNK - 1) / CHUNK;
+
+            auto worker = [&](Tally& t){
+                t.lengths.assign(maxRounds + 1, 0);
+                t.wins.assign(players, 0);
+                RandomGenerator rng(seed);
+                for(long c; (c = nextChunk.fetch_add(1, memory_order_relaxed)) < chunks; ){
+                    rng.reseed(seed, c);
+                    long end = min(games, (c + 1) * CHUNK);
+                    for(long g = c * CHUNK; g < end; g++){
+                        int winner, rounds = play(rng, winner);
+                        if(winner < 0){
+                            t.unfinished++;
+                            continue;
+                        }
+                        t.lengths[rounds]++;
+                        t.wins[winner]++;
+                    }
+                }
+            };
+
+            auto start = chrono::steady_clock::now();
+            vector<thread> pool;
+            for(unsigned i = 1; i < threads; i++)
+                pool.emplace_back(worker, ref(tallies[i]));
+            worker(tallies[0]);
+            for(auto& th : pool)
+                th.join();
+
+            SimulationReport rep;
+            rep.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            rep.games = games;
+            rep.threads = threads;
+            rep.lengths.assign(maxRounds + 1, 0);
+            rep.winsBySeat.assign(players, 0);
+            for(auto& t : tallies){
+                for(int r = 0; r <= maxRounds; r++)
+                    rep.lengths[r] += t.lengths[r];
+                for(int s = 0; s < players; s++)
+                    rep.winsBySeat[s] += t.wins[s];
+                rep.unfinished += t.unfinished;
+            }
+            while(rep.lengths.size() > 1 && rep.lengths.back() == 0)
+                rep.lengths.pop_back();
+            return rep;
         }
 };
 
+/*
+    Exact solver: the board as an absorbing Markov chain over squares
+    0..size, the last square absorbing.
+        - Nothing is stored as a matrix. A step of the chain is a dense
+          6-wide stencil (every square receives a sixth of the six squares
+          below it, a loop the compiler vectorises) plus a sparse correction
+          list sorted by square: snakes and ladders move what landed on their
+          square, and the last few squares keep the mass of rolls that
+          overshoot. O(size + links) per turn, touched front to back.
+        - Only the span of squares that can hold mass is stepped; it grows
+          by six a turn and by wherever a link lands, and sheds squares at the
+          bottom whose mass has become negligible.
+        - Expected turns come straight from E[s] = 1 + sum E[move(s, r)] / 6,
+          a banded linear system.
+        - N seats: seat k wins in round t when it finishes then, the seats
+          before it have not finished by round t and those after it not by
+          round t - 1, which follows from one player's distribution.
+*/
+class MarkovSolver{
+        const Board &board;
+        vector<double> finish;          // finish[t] = P(one player finishes on turn t)
+
+        // q[j] = sixth of p[j-6..j-1]; __restrict tells the compiler it may vectorise without alias checks
+        static void stencil(const double *__restrict p, double *__restrict q, int lo, int hi){
+            for(int j = lo; j <= hi; j++)
+                q[j] = (p[j - 1] + p[j - 2] + p[j - 3] + p[j - 4] + p[j - 5] + p[j - 6]) * (1.0 / 6);
+        }
+
+    public:
+        struct Game{
+            vector<double>  rounds;         // rounds[t] = P(game ends in round t)
+            vector<double>  winBySeat;
+            double          expectedRounds{0};
+        };
+
+        explicit MarkovSolver(const Board& _board) : board(_board) {}
+
+        /*
+            Solves (I - T) E = 1 over the unfinished squares. Every move
+            spans at most six squares plus the longest link, so the matrix is
+            banded and, being diagonally dominant, eliminates in place without
+            pivoting in O(size * band^2). Infinite if the end is unreachable.
+        */
+        double expectedTurns() const {
+            const int n = board.getSize();
+            int below = 0, above = 0;
+            for(int s = 0; s < n; s++)
+                for(int r = 1; r <= 6; r++){
+                    int t = board.move(s, r);
+                    if(t < n){
+                        below = max(below, s - t);
+                        above = max(above, t - s);
+                    }
+                }
+
+            const int w = below + above + 1;
+            vector<double> band((size_t)n * w, 0), e(n, 1);
+            auto at = [&](int i, int j) -> double& { return band[(size_t)i * w + j - i + below]; };
+            for(int s = 0; s < n; s++){
+                at(s, s) += 1;
+                for(int r = 1; r <= 6; r++){
+                    int t = board.move(s, r);
+                    if(t < n)
+                        at(s, t) -= 1.0 / 6;
+                }
+            }
+
+            for(int k = 0; k < n; k++){
+                double pivot = at(k, k);
+                if(pivot < 1e-12)
+                    return numeric_limits<double>::infinity();
+                int end = min(n - 1, k + above);
+                for(int i = k + 1; i <= min(n - 1, k + below); i++){
+                    double f = at(i, k) / pivot;
+                    if(f == 0)
+                        continue;
+                    double *ri = &at(i, k);
+                    const double *rk = &at(k, k);
+                    for(int j = 0; j <= end - k; j++)
+                        ri[j] -= f * rk[j];
+                    e[i] -= f * e[k];
+                }
+            }
+            for(int i = n - 1; i >= 0; i--){
+                double sum = e[i];
+                for(int j = i + 1; j <= min(n - 1, i + above); j++)
+                    sum -= at(i, j) * e[j];
+                e[i] = sum / at(i, i);
+            }
+            return e[0];
+        }
+
+        // Turn-count distribution of one player, until all but `eps` of the mass has finished
+        const vector<double>& turnDistribution(double eps=1e-12, int maxTurns=10000000){
+            if(!finish.empty())
+                return finish;
+
+            const int n = board.getSize(), PAD = 6;
+            const double FLOOR = 1e-30;
+            vector<pair<int, int>> links = board.getLinks();
+            sort(links.begin(), links.end());
+            vector<double> p(n + 1 + PAD, 0), q(n + 1 + PAD, 0), moved(links.size());
+            double *P = p.data() + PAD, *Q = q.data() + PAD;     // P[-6..-1] stay 0
+
+            P[0] = 1;
+            int lo = 0, hi = 0;
+            double done = 0;
+            finish.push_back(0);
+
+            for(int t = 1; t <= maxTurns && 1 - done > eps; t++){
+                int top = min(n, hi + 6);
+                stencil(P, Q, lo, top);
+
+                // Links move what landed on them (read all first: a link may land on another's square)
+                auto first = lower_bound(links.begin(), links.end(), make_pair(lo, INT_MIN));
+                auto last = upper_bound(links.begin(), links.end(), make_pair(top, INT_MAX));
+                for(auto it = first; it != last; it++)
+                    moved[it - links.begin()] = Q[it->first];
+                for(auto it = first; it != last; it++){
+                    double m = moved[it - links.begin()];
+                    Q[it->first] -= m;
+                    Q[it->second] += m;
+                    if(m != 0){
+                        lo = min(lo, it->second);
+                        hi = max(hi, it->second);
+                    }
+                }
+
+                for(int s = max(lo, n - 5); s <= min(hi, n - 1); s++)
+                    Q[s] += P[s] * (s + 6 - n) * (1.0 / 6);          // Rolls that overshoot stay put
+
+                finish.push_back(Q[n]);
+                done += Q[n];
+                Q[n] = 0;
+                hi = max(hi, top);
+                // Mass left far behind fades towards denormals, which are slow; below FLOOR it is let go
+                while(lo < hi && fabs(Q[lo]) < FLOOR && fabs(P[lo]) < FLOOR){
+                    Q[lo] = P[lo] = 0;
+                    lo++;
+                }
+                swap(P, Q);
+                if(lo == hi && fabs(P[lo]) < FLOOR)
+                    break;                      // Everything finished; `done` is only off by rounding
+            }
+            return finish;
+        }
+
+        Game game(int players){
+            const vector<double>& f = turnDistribution();
+            Game g;
+            g.rounds.assign(f.size(), 0);
+            g.winBySeat.assign(players, 0);
+
+            double survive = 1;                 // P(one player has not finished by the previous round)
+            for(size_t t = 1; t < f.size(); t++){
+                double now = max(0.0, survive - f[t]);
+                for(int k = 0; k < players; k++){
+                    double w = f[t] * pow(now, k) * pow(survive, players - 1 - k);
+                    g.rounds[t] += w;
+                    g.winBySeat[k] += w;
+                }
+                g.expectedRounds += t * g.rounds[t];
+                survive = now;
+            }
+            return g;
+        }
+};
+
+/*
+    Unbounded queue between threads: producers push one item at a time, the
+    consumer swaps out everything queued in one go, so the lock is held for a
+    push_back or a swap and never while items are handled. A producer only
+    signals when the consumer is actually asleep.
+*/
+template<class T>
+class Mailbox{
+        mutex               m;
+        condition_variable  cv;
+        vector<T>           items;
+        bool                sleeping{false}, closed{false};
+
+    public:
+        void push(const T& item){
+            bool wake;
+            {
+                lock_guard<mutex> lock(m);
+                items.push_back(item);
+                wake = sleeping;
+                sleeping = false;
+            }
+            if(wake)
+                cv.notify_one();
+        }
+
+        // Swaps the queued items into `out` (left empty by the caller), waiting until `until` if there are none. False once closed.
+        bool take(vector<T>& out, chrono::steady_clock::time_point until){
+            unique_lock<mutex> lock(m);
+            if(items.empty() && !closed){
+                sleeping = true;
+                cv.wait_until(lock, until, [&]{ return !items.empty() || closed; });
+                sleeping = false;
+            }
+            out.swap(items);
+            return !closed;
+        }
+
+        void close(){
+            {
+                lock_guard<mutex> lock(m);
+                closed = true;
+            }
+            cv.notify_all();
+        }
+};
+
+/*
+    Many concurrent games in one process, e.g. behind a network front end.
+        - A game is a 28-byte record in its shard's arena: squares as 16-bit
+          ints for up to MAX_SEATS seats, the turn, and its timer links.
+          Finished games go on a free list and their slot is reused; the
+          generation in the GameId turns a stale id into a rejection.
+        - One shard per core, each with a worker thread that alone touches
+          its games. Commands are queued to the shard in the GameId, so game
+          state needs no locks; commands the callback issues on the worker's
+          own thread skip the mailbox.
+        - Turn timeouts run on a per-shard timing wheel threaded through the
+          game records: re-arming on every move is an O(1) relink, with no
+          allocation and no stale entries. A seat that times out loses its
+          turn.
+    Everything that happens is reported to one callback, on the shard's
+    thread, which must not block.
+*/
+class GameServer{
+    public:
+        using GameId = uint64_t;                    // shard:8 | slot:24 | generation:32
+
+        static constexpr int MAX_SEATS = 4;
+
+        enum class EventKind : uint8_t { CREATED, MOVED, WON, TIMEOUT, REJECTED };
+
+        struct Event{
+            GameId      game;
+            uint64_t    tag;                        // From createGame(), on CREATED
+            EventKind   kind;
+            uint8_t     seat;                       // Who moved or timed out
+            uint8_t     roll;
+            uint8_t     next;                       // Seat to move now
+            uint16_t    from, to;
+        };
+
+        struct Config{
+            unsigned                shards = max(1u, thread::hardware_concurrency());
+            chrono::milliseconds    turnTimeout{30'000};
+            chrono::milliseconds    tick{10};       // Timer resolution
+            uint64_t                seed = 1;
+        };
+
+        struct Stats{
+            long    created{0}, finished{0}, moves{0}, timeouts{0}, rejected{0};
+            size_t  arenaBytes{0};                  // Game records, free lists and wheels, as allocated
+
+            long live() const { return created - finished; }
+        };
+
+    private:
+        static constexpr uint32_t   NIL = UINT32_MAX;
+        static constexpr uint32_t   WHEEL = 1 << 12;        // Slots; later deadlines wait out extra turns of the wheel
+        static constexpr uint32_t   MAX_SLOTS = 1 << 24;
+
+        struct Game{
+            uint32_t    gen;                        // Bumped when the slot is freed
+            uint32_t    prev, next;                 // Games due in the same wheel slot
+            uint32_t    deadline;                   // Tick at which the current turn times out
+            uint16_t    pos[MAX_SEATS];
+            uint8_t     players;                    // 0: slot is free
+            uint8_t     turn;
+        };
+
+        enum CommandKind : uint8_t { CREATE, MOVE };
+
+        struct Command{
+            uint64_t    arg;                        // GameId, or the tag for CREATE
+            uint8_t     kind;
+            uint8_t     seat;                       // Or the player count for CREATE
+        };
+
+        struct alignas(64) Shard{
+            uint8_t             index;
+            Mailbox<Command>    inbox;              // From other threads
+
+            // Only touched by the worker
+            vector<Command>     local;              // Queued by the worker itself
+            vector<Game>        games;
+            vector<uint32_t>    freeSlots;
+            vector<uint32_t>    wheel;              // Tick % WHEEL -> first game due
+            uint32_t            now{0};             // Last tick expired
+            long                armed{0};
+            RandomGenerator     dice;
+            thread              worker;
+
+            atomic<long>        created{0}, finished{0}, moves{0}, timeouts{0}, rejected{0};
+            atomic<size_t>      bytes{0};
+
+            template<class C>
+            static void bump(atomic<C>& counter, C by=1){
+                counter.store(counter.load(memory_order_relaxed) + by, memory_order_relaxed);    // Single writer
+            }
+        };
+
+        const Board                 &board;
+        Config                      cfg;
+        function<void(const Event&)> onEvent;
+        vector<unique_ptr<Shard>>   shards;
+        chrono::steady_clock::time_point epoch;
+        uint32_t                    timeoutTicks;
+        atomic<unsigned>            nextShard{0};
+
+        static inline thread_local Shard *current = nullptr;
+
+        static GameId makeId(unsigned shard, uint32_t slot, uint32_t gen){
+            return (GameId)shard << 56 | (GameId)slot << 32 | gen;
+        }
+
+        Shard* ownShard() const {
+            for(auto& s : shards)
+                if(s.get() == current)
+                    return current;
+            return nullptr;
+        }
+
+        void submit(Shard& s, const Command& c){
+            if(current == &s)
+                s.local.push_back(c);
+            else
+                s.inbox.push(c);
+        }
+
+        uint32_t tickNow() const {
+            return (uint32_t)((chrono::steady_clock::now() - epoch) / cfg.tick);
+        }
+
+        void link(Shard& s, uint32_t i, uint32_t deadline){
+            Game& g = s.games[i];
+            uint32_t& head = s.wheel[deadline % WHEEL];
+            g.deadline = deadline;
+            g.prev = NIL;
+            g.next = head;
+            if(head != NIL)
+                s.games[head].prev = i;
+            head = i;
+            s.armed++;
+        }
+
+        void unlink(Shard& s, uint32_t i){
+            Game& g = s.games[i];
+            if(g.prev != NIL)
+                s.games[g.prev].next = g.next;
+            else
+                s.wheel[g.deadline % WHEEL] = g.next;
+            if(g.next != NIL)
+                s.games[g.next].prev = g.prev;
+            s.armed--;
+        }
+
+        void updateBytes(Shard& s){
+            s.bytes.store(s.games.capacity() * sizeof(Game) + s.freeSlots.capacity() * sizeof(uint32_t) + WHEEL * sizeof(uint32_t), memory_order_relaxed);
+        }
+
+        void reject(Shard& s, const Command& c){
+            Shard::bump(s.rejected);
+            onEvent(Event{c.kind == MOVE ? c.arg : 0, c.kind == CREATE ? c.arg : 0, EventKind::REJECTED, c.seat, 0, 0, 0, 0});
+        }
+
+        void create(Shard& s, const Command& c){
+            int players = c.seat;
+            if(players < 1 || players > MAX_SEATS || (s.freeSlots.empty() && s.games.size() >= MAX_SLOTS))
+                return reject(s, c);
+            uint32_t i;
+            if(!s.freeSlots.empty()){
+                i = s.freeSlots.back();
+                s.freeSlots.pop_back();
+            } else {
+                i = s.games.size();
+                size_t cap = s.games.capacity();
+                s.games.push_back(Game{0, NIL, NIL, 0, {0}, 0, 0});
+                if(s.games.capacity() != cap)
+                    updateBytes(s);
+            }
+            Game& g = s.games[i];
+            fill(begin(g.pos), end(g.pos), 0);
+            g.players = players;
+            g.turn = 0;
+            link(s, i, s.now + timeoutTicks);
+            Shard::bump(s.created);
+            onEvent(Event{makeId(s.index, i, g.gen), c.arg, EventKind::CREATED, 0, 0, 0, 0, 0});
+        }
+
+        void move(Shard& s, const Command& c){
+            uint32_t i = (uint32_t)(c.arg >> 32) & (MAX_SLOTS - 1);
+            if(i >= s.games.size() || s.games[i].gen != (uint32_t)c.arg || !s.games[i].players || s.games[i].turn != c.seat)
+                return reject(s, c);
+
+            Game& g = s.games[i];
+            int roll = s.dice.getRandom(1, 6), from = g.pos[c.seat], to = board.move(from, roll);
+            g.pos[c.seat] = to;
+            unlink(s, i);
+            Shard::bump(s.moves);
+            if(to == board.getSize()){
+                g.players = 0;
+                g.gen++;
+                size_t cap = s.freeSlots.capacity();
+                s.freeSlots.push_back(i);
+                if(s.freeSlots.capacity() != cap)
+                    updateBytes(s);
+                Shard::bump(s.finished);
+                onEvent(Event{c.arg, 0, EventKind::WON, c.seat, (uint8_t)roll, c.seat, (uint16_t)from, (uint16_t)to});
+                return;
+            }
+            g.turn = (g.turn + 1) % g.players;
+            link(s, i, s.now + timeoutTicks);
+            onEvent(Event{c.arg, 0, EventKind::MOVED, c.seat, (uint8_t)roll, g.turn, (uint16_t)from, (uint16_t)to});
+        }
+
+        // Fires every turn timeout up to tick `until`
+        void expire(Shard& s, uint32_t until){
+            if(!s.armed){
+                s.now = max(s.now, until);
+                return;
+            }
+            while(s.now < until){
+                s.now++;
+                for(uint32_t i = s.wheel[s.now % WHEEL]; i != NIL; ){
+                    Game& g = s.games[i];
+                    uint32_t next = g.next;
+                    if(g.deadline == s.now){
+                        uint8_t seat = g.turn;
+                        g.turn = (g.turn + 1) % g.players;
+                        unlink(s, i);
+                        link(s, i, s.now + timeoutTicks);
+                        Shard::bump(s.timeouts);
+                        onEvent(Event{makeId(s.index, i, g.gen), 0, EventKind::TIMEOUT, seat, 0, g.turn, g.pos[seat], g.pos[seat]});
+                    }
+                    i = next;
+                }
+            }
+        }
+
+        void work(Shard& s){
+            current = &s;
+            vector<Command> batch;
+            for(bool open = true; open; ){
+                auto wake = !s.local.empty() ? chrono::steady_clock::now()
+                          : s.armed ? epoch + cfg.tick * (s.now + 1)
+                          : chrono::steady_clock::now() + chrono::seconds(1);
+                open = s.inbox.take(batch, wake);
+                // Then one round of what the callback queued here, so a busy callback cannot starve the mailbox
+                batch.insert(batch.end(), s.local.begin(), s.local.end());
+                s.local.clear();
+                for(const Command& c : batch)
+                    c.kind == CREATE ? create(s, c) : move(s, c);
+                batch.clear();
+                expire(s, tickNow());
+            }
+            current = nullptr;
+        }
+
+    public:
+        GameServer(const Board& _board, Config _cfg, function<void(const Event&)> _onEvent)
+                : board(_board), cfg(_cfg), onEvent(std::move(_onEvent)), epoch(chrono::steady_clock::now()) {
+            if(board.getSize() > UINT16_MAX)
+                throw invalid_argument("board too big for 16-bit squares");
+            if(cfg.shards < 1 || cfg.shards > 256)
+                throw invalid_argument("need 1 to 256 shards");
+            if(cfg.tick.count() < 1)
+                throw invalid_argument("tick must be at least 1ms");
+            timeoutTicks = max<uint32_t>(1, cfg.turnTimeout / cfg.tick);
+            for(unsigned i = 0; i < cfg.shards; i++){
+                shards.push_back(make_unique<Shard>());
+                Shard& s = *shards.back();
+                s.index = i;
+                s.wheel.assign(WHEEL, NIL);
+                s.dice.reseed(cfg.seed, i);
+                updateBytes(s);
+            }
+            for(auto& s : shards)
+                s->worker = thread(&GameServer::work, this, ref(*s));
+        }
+
+        ~GameServer(){
+            for(auto& s : shards)
+                s->inbox.close();
+            for(auto& s : shards)
+                s->worker.join();
+        }
+
+        GameServer(const GameServer&) = delete;
+        GameServer& operator=(const GameServer&) = delete;
+
+        // Asynchronous: the id comes back in a CREATED event carrying `tag`. From a callback, the game stays on that shard.
+        void createGame(int players, uint64_t tag=0){
+            Shard *s = ownShard();
+            if(!s)
+                s = shards[nextShard.fetch_add(1, memory_order_relaxed) % shards.size()].get();
+            submit(*s, Command{tag, CREATE, (uint8_t)min(players, 255)});
+        }
+
+        // Rolls for `seat` if it is that seat's turn; otherwise a REJECTED event
+        void move(GameId game, int seat){
+            unsigned shard = game >> 56;
+            if(shard >= shards.size())
+                throw invalid_argument("no such shard in game id");
+            submit(*shards[shard], Command{game, MOVE, (uint8_t)min(max(seat, 0), 255)});
+        }
+
+        Stats stats() const {
+            Stats st;
+            for(auto& s : shards){
+                st.created += s->created.load(memory_order_relaxed);
+                st.finished += s->finished.load(memory_order_relaxed);
+                st.moves += s->moves.load(memory_order_relaxed);
+                st.timeouts += s->timeouts.load(memory_order_relaxed);
+                st.rejected += s->rejected.load(memory_order_relaxed);
+                st.arenaBytes += s->bytes.load(memory_order_relaxed);
+            }
+            return st;
+        }
+
+        static constexpr size_t recordBytes() { return sizeof(Game); }
+};
+
+// `links` snakes and ladders (half each, up to `reach` squares long) dropped on random squares
+Board randomBoard(int size, int links, int reach, uint64_t seed){
+    Board b(size);
+    RandomGenerator rng(seed);
+    for(int placed = 0; placed < links; ){
+        int from = rng.getRandom(2, size - 1), to;
+        try{
+            if(placed % 2){
+                to = rng.getRandom(max(1, from - reach), from - 1);
+                b.addSnake(from, to);
+            } else {
+                to = rng.getRandom(from + 1, min(size, from + reach));
+                b.addLadder(from, to);
+            }
+            placed++;
+        } catch(const invalid_argument&){}          // Square taken, draw again
+    }
+    return b;
+}
+
+// The classic 100-square Milton Bradley layout
+Board classicBoard(){
+    Board b(100);
+    for(auto l : vector<pair<int, int>>{{1, 38}, {4, 14}, {9, 31}, {21, 42}, {28, 84}, {36, 44}, {51, 67}, {71, 91}, {80, 100}})
+        b.addLadder(l.first, l.second);
+    for(auto s : vector<pair<int, int>>{{16, 6}, {47, 26}, {49, 11}, {56, 53}, {62, 19}, {64, 60}, {87, 24}, {93, 73}, {95, 75}, {98, 78}})
+        b.addSnake(s.first, s.second);
+    return b;
+}
+
+/*
+    Exact vs simulated on one board: expected rounds and win rate by seat (in
+    simulation standard errors), and the total variation distance between the
+    two round-count distributions over 50 bins.
+*/
+void CrossCheck(const Board& board, int players, long games, int maxRounds=1000){
+    MarkovSolver solver(board);
+    MarkovSolver::Game exact = solver.game(players);
+    SimulationReport sim = GameEngine(board, players, maxRounds).run(games);
+
+    double simMean = sim.meanLength(), var = 0;
+    for(size_t r = 0; r < sim.lengths.size(); r++)
+        var += sim.lengths[r] * (r - simMean) * (r - simMean);
+    double se = sqrt(var / sim.games / sim.games);
+
+    double worst = 0;
+    for(int k = 0; k < players; k++){
+        double rate = (double)sim.winsBySeat[k] / sim.games, e = exact.winBySeat[k];
+        if(e > 0 && e < 1)
+            worst = max(worst, fabs(rate - e) / sqrt(e * (1 - e) / sim.games));
+    }
+
+    size_t span = max(exact.rounds.size(), sim.lengths.size()), width = (span + 49) / 50;
+    vector<double> bins(50, 0);
+    for(size_t t = 0; t < span; t++){
+        double a = t < exact.rounds.size() ? exact.rounds[t] : 0, b = t < sim.lengths.size() ? (double)sim.lengths[t] / sim.games : 0;
+        bins[t / width] += a - b;
+    }
+    double tv = 0;
+    for(double d : bins)
+        tv += fabs(d) / 2;
+
+    cout << "  " << players << " player" << (players > 1 ? "s" : " ") << ", " << games << " games: rounds exact " << fixed << setprecision(3)
+         << exact.expectedRounds << ", simulated " << simMean << " (" << setprecision(1) << (simMean - exact.expectedRounds) / se
+         << " se); seat win rates within " << worst << " se; TV distance " << setprecision(4) << tv << "\n";
+}
+
+long residentBytes(){
+    long pages = 0, resident = 0;
+    ifstream("/proc/self/statm") >> pages >> resident;
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+/*
+    Local load generator: `games` games always in play, each seat a bot that
+    moves as soon as it is its turn, and a finished game replaced by a new
+    one. Bots live on `clients` threads of their own, so every move crosses
+    from a client thread to the game's shard like a network request would.
+    Reports moves/sec and memory per live game: the arena as allocated, and
+    the process's resident growth, which also counts queues and the heap.
+*/
+void LoadTest(const Board& board, long games, int players, double seconds, unsigned shards, unsigned clients){
+    struct Turn{
+        GameServer::GameId  game;
+        uint8_t             seat;
+    };
+    vector<unique_ptr<Mailbox<Turn>>> bots(clients);
+    for(auto& b : bots)
+        b = make_unique<Mailbox<Turn>>();
+
+    atomic<bool> running{true};
+    atomic<long> pendingCreates{games};
+    GameServer *server = nullptr;
+    auto onEvent = [&](const GameServer::Event& e){
+        if(!running.load(memory_order_relaxed))
+            return;
+        switch(e.kind){
+            case GameServer::EventKind::CREATED:
+                pendingCreates.fetch_sub(1, memory_order_relaxed);
+                [[fallthrough]];
+            case GameServer::EventKind::MOVED:
+            case GameServer::EventKind::TIMEOUT:
+                bots[(e.game >> 32) % clients]->push(Turn{e.game, e.next});
+                break;
+            case GameServer::EventKind::WON:
+                server->createGame(players);
+                break;
+            case GameServer::EventKind::REJECTED:
+                break;
+        }
+    };
+
+    long rssBefore = residentBytes();
+    GameServer::Config cfg;
+    cfg.shards = shards;
+    GameServer srv(board, cfg, onEvent);
+    server = &srv;
+
+    vector<thread> pool;
+    for(unsigned c = 0; c < clients; c++)
+        pool.emplace_back([&, c]{
+            vector<Turn> turns;
+            while(bots[c]->take(turns, chrono::steady_clock::now() + chrono::milliseconds(100))){
+                for(const Turn& t : turns)
+                    srv.move(t.game, t.seat);
+                turns.clear();
+            }
+        });
+
+    for(long g = 0; g < games; g++)
+        srv.createGame(players);
+    while(pendingCreates.load() > 0)
+        this_thread::sleep_for(chrono::milliseconds(1));
+
+    GameServer::Stats before = srv.stats();
+    auto start = chrono::steady_clock::now();
+    this_thread::sleep_for(chrono::duration<double>(seconds));
+    GameServer::Stats after = srv.stats();
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    long rssAfter = residentBytes();
+
+    running = false;
+    for(auto& b : bots)
+        b->close();
+    for(auto& th : pool)
+        th.join();
+
+    long moves = after.moves - before.moves, live = after.live();
+    cout << games << " games x " << players << " players, " << shards << " shard" << (shards > 1 ? "s" : "") << ", " << clients << " client threads: "
+         << fixed << setprecision(0) << moves / elapsed << " moves/sec, " << (after.finished - before.finished) / elapsed << " games finished/sec, "
+         << after.rejected << " rejected\n";
+    cout << "  memory per live game: " << GameServer::recordBytes() << " B record, " << setprecision(1) << (double)after.arenaBytes / live
+         << " B arena as allocated, " << (double)(rssAfter - rssBefore) / live << " B process RSS growth\n";
+}
+
 int main(){
+    Board board = classicBoard();
+    unsigned cores = max(1u, thread::hardware_concurrency());
+
+    for(int players : {1, 2, 4}){
+        cout << "--- Classic board, " << players << " player" << (players > 1 ? "s" : "") << " ---\n";
+        GameEngine(board, players).run(4'000'000, cores).print();
+        cout << "\n";
+    }
+
+    cout << "--- Scaling (2 players, 4M games) ---\n";
+    GameEngine engine(board, 2);
+    for(unsigned t = 1; t <= cores; t *= 2){
+        SimulationReport r = engine.run(4'000'000, t);
+        cout << t << " threads: " << fixed << setprecision(0) << r.games / r.seconds << " games/sec, seat 1 wins "
+             << setprecision(3) << 100.0 * r.winsBySeat[0] / r.games << "%\n";
+    }
+
+    cout << "\n--- Exact solver vs simulation (classic board, 4M games each) ---\n";
+    MarkovSolver classic(board);
+    cout << "one player: expected turns " << setprecision(6) << classic.expectedTurns() << " (linear solve)\n";
+    for(int players : {1, 2, 4})
+        CrossCheck(board, players, 4'000'000);
+
+    cout << "\n--- Exact solver on large random boards (5% of squares linked, links up to 30 long) ---\n";
+    for(int size : {10'000, 100'000}){
+        Board big = randomBoard(size, size / 20, 30, 7);
+        MarkovSolver solver(big);
+
+        auto start = chrono::steady_clock::now();
+        double e = solver.expectedTurns();
+        double tSolve = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+        start = chrono::steady_clock::now();
+        const vector<double>& f = solver.turnDistribution();
+        double tDist = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        double mean = 0;
+        for(size_t t = 0; t < f.size(); t++)
+            mean += t * f[t];
+
+        cout << size << " squares: expected turns " << setprecision(3) << e << " in " << setprecision(1) << tSolve << " ms; distribution over "
+             << f.size() - 1 << " turns (mean " << setprecision(3) << mean << ") in " << setprecision(1) << tDist << " ms\n";
+        CrossCheck(big, 2, size > 10'000 ? 5'000 : 100'000, size);
+    }
+    cout << "\n--- Game server: turn timeouts (2000 idle 2-player games, 50 ms timeout) ---\n";
+    {
+        atomic<long> timedOut{0};
+        GameServer::Config cfg;
+        cfg.turnTimeout = chrono::milliseconds(50);
+        cfg.tick = chrono::milliseconds(5);
+        GameServer idle(board, cfg, [&](const GameServer::Event& e){
+            if(e.kind == GameServer::EventKind::TIMEOUT)
+                timedOut++;
+        });
+        for(int g = 0; g < 2000; g++)
+            idle.createGame(2);
+        this_thread::sleep_for(chrono::milliseconds(520));
+        GameServer::Stats st = idle.stats();
+        cout << st.timeouts << " turns timed out in 520 ms (about " << 2000 * 10 << " expected), " << timedOut << " TIMEOUT events\n";
+    }
 
-}
\ No newline at end of file
+    cout << "\n--- Game server: load generator ---\n";
+    for(long games : {10'000L, 200'000L})
+        LoadTest(board, games, 2, 2.0, cores, 2);
+    LoadTest(board, 200'000, 4, 2.0, cores, 2);
+}
@@ -0,0 +1,282 @@
+#ifndef UTILS_PRNG_H
+#define UTILS_PRNG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+/*
+    Pseudo-random numbers, shared by the projects in this repo:
+        - Xoshiro256ss : xoshiro256**, 64-bit output, 2^256 - 1 period.
+                         jump() / longJump() skip 2^128 / 2^192 draws, which
+                         carves one seed into non-overlapping per-thread streams
+        - Pcg32        : PCG-XSH-RR, 32-bit output, 2^63 selectable streams
+                         and advance(n) in O(log n)
+        - Xoshiro256ssBatch : 8 xoshiro256** lanes in vector registers, so
+                         fill() is SIMD (the multiplies are by 5 and 9, i.e.
+                         shifts and adds, which every vector ISA has)
+        - bounded / uniform : Lemire's multiply-shift bounded integers, exact
+                         (rejection only inside the tiny biased slice)
+
+    Every generator is fully determined by its seed (and stream): no global
+    state, no time(), safe to own one per thread.
+*/
+namespace prng{
+
+inline uint64_t rotl(uint64_t x, int k){
+    return (x << k) | (x >> (64 - k));
+}
+
+// Seed expander: consecutive inputs give statistically unrelated outputs
+inline uint64_t splitmix64(uint64_t& x){
+    uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+class Xoshiro256ss{
+        friend class Xoshiro256ssBatch;
+
+        uint64_t s[4];
+
+        void jumpBy(const uint64_t (&poly)[4]){
+            uint64_t t[4] = {0, 0, 0, 0};
+            for(uint64_t word : poly)
+                for(int b = 0; b < 64; b++){
+                    if(word & (1ULL << b))
+                        for(int i = 0; i < 4; i++)
+                            t[i] ^= s[i];
+                    next();
+                }
+            for(int i = 0; i < 4; i++)
+                s[i] = t[i];
+        }
+
+    public:
+        using result_type = uint64_t;
+
+        explicit Xoshiro256ss(uint64_t seed=0){
+            for(auto& x : s)
+                x = splitmix64(seed);
+        }
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+        uint64_t next(){
+            const uint64_t result = rotl(s[1] * 5, 7) * 9;
+            const uint64_t t = s[1] << 17;
+            s[2] ^= s[0];
+            s[3] ^= s[1];
+            s[1] ^= s[2];
+            s[0] ^= s[3];
+            s[2] ^= t;
+            s[3] = rotl(s[3], 45);
+            return result;
+        }
+
+        result_type operator()() { return next(); }
+
+        // Same as 2^128 calls to next()
+        void jump(){
+            static const uint64_t poly[4] = {0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL, 0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL};
+            jumpBy(poly);
+        }
+
+        // Same as 2^192 calls to next()
+        void longJump(){
+            static const uint64_t poly[4] = {0x76E15D3EFEFDCBBFULL, 0xC5004E441C522FB3ULL, 0x77710069854EE241ULL, 0x39109BB02ACBE635ULL};
+            jumpBy(poly);
+        }
+
+        // n generators 2^128 draws apart, e.g. one per thread
+        static std::vector<Xoshiro256ss> streams(uint64_t seed, size_t n){
+            std::vector<Xoshiro256ss> out;
+            Xoshiro256ss g(seed);
+            for(size_t i = 0; i < n; i++){
+                out.push_back(g);
+                g.jump();
+            }
+            return out;
+        }
+};
+
+class Pcg32{
+        static constexpr uint64_t MULT = 6364136223846793005ULL;
+
+        uint64_t state{0}, inc{1};
+
+    public:
+        using result_type = uint32_t;
+
+        // Different streams never overlap, whatever the seeds
+        explicit Pcg32(uint64_t seed=0, uint64_t stream=0) : inc((stream << 1) | 1) {
+            next();
+            state += seed;
+            next();
+        }
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+        uint32_t next(){
+            uint64_t old = state;
+            state = old * MULT + inc;
+            uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+            uint32_t rot = (uint32_t)(old >> 59);
+            return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+        }
+
+        result_type operator()() { return next(); }
+
+        // Same as n calls to next(), by squaring the LCG step
+        void advance(uint64_t n){
+            uint64_t mult = MULT, plus = inc, accMult = 1, accPlus = 0;
+            for(; n; n >>= 1){
+                if(n & 1){
+                    accMult *= mult;
+                    accPlus = accPlus * mult + plus;
+                }
+                plus *= mult + 1;
+                mult *= mult;
+            }
+            state = accMult * state + accPlus;
+        }
+};
+
+/*
+    Eight xoshiro256** generators side by side, lane i started i jumps after
+    the seed, with the state in GCC/Clang vector types: two halves of four
+    64-bit lanes, AVX2's native width (AVX-512 and SSE2 handle them in one or
+    two registers each). Plain arrays defeat the auto-vectoriser here, and
+    wider generic vectors spill on AVX2. Output is lane-interleaved blocks of
+    eight; a fill of n values consumes ceil(n / 8) blocks, so the sequence
+    only depends on the seed and the sizes asked for, not on the ISA.
+*/
+class Xoshiro256ssBatch{
+    public:
+        static constexpr int LANES = 8;
+
+    private:
+        typedef uint64_t Vec __attribute__((vector_size(4 * sizeof(uint64_t))));
+
+        Vec s[2][4];            // [half][state word]
+
+    public:
+        explicit Xoshiro256ssBatch(uint64_t seed=0){
+            auto lanes = Xoshiro256ss::streams(seed, LANES);
+            for(int l = 0; l < LANES; l++)
+                for(int w = 0; w < 4; w++)
+                    s[l / 4][w][l % 4] = lanes[l].s[w];
+        }
+
+        // Written out in one body: passing Vec to a helper goes through memory unless it is native width
+        void fill(uint64_t *out, size_t n){
+            Vec a0 = s[0][0], a1 = s[0][1], a2 = s[0][2], a3 = s[0][3];
+            Vec b0 = s[1][0], b1 = s[1][1], b2 = s[1][2], b3 = s[1][3];
+            for(size_t i = 0; i < n; i += LANES){
+                Vec x = a1 + (a1 << 2), y = b1 + (b1 << 2);             // * 5
+                x = (x << 7) | (x >> 57);
+                y = (y << 7) | (y >> 57);
+                x = x + (x << 3);                                       // * 9
+                y = y + (y << 3);
+                if(n - i >= LANES){
+                    std::memcpy(out + i, &x, sizeof x);
+                    std::memcpy(out + i + 4, &y, sizeof y);
+                } else {
+                    uint64_t tail[LANES];
+                    std::memcpy(tail, &x, sizeof x);
+                    std::memcpy(tail + 4, &y, sizeof y);
+                    std::memcpy(out + i, tail, (n - i) * sizeof(uint64_t));
+                }
+
+                Vec t = a1 << 17, u = b1 << 17;
+                a2 ^= a0;  b2 ^= b0;
+                a3 ^= a1;  b3 ^= b1;
+                a1 ^= a2;  b1 ^= b2;
+                a0 ^= a3;  b0 ^= b3;
+                a2 ^= t;   b2 ^= u;
+                a3 = (a3 << 45) | (a3 >> 19);
+                b3 = (b3 << 45) | (b3 >> 19);
+            }
+            s[0][0] = a0; s[0][1] = a1; s[0][2] = a2; s[0][3] = a3;
+            s[1][0] = b0; s[1][1] = b1; s[1][2] = b2; s[1][3] = b3;
+        }
+
+        void fill(std::vector<uint64_t>& out) { fill(out.data(), out.size()); }
+};
+
+template<class G>
+inline uint32_t next32(G& g){
+    if constexpr (sizeof(typename G::result_type) >= 8)
+        return (uint32_t)(g() >> 32);          // High bits are the strongest
+    else
+        return (uint32_t)g();
+}
+
+template<class G>
+inline uint64_t next64(G& g){
+    if constexpr (sizeof(typename G::result_type) >= 8)
+        return g();
+    else {
+        uint64_t hi = g();
+        return (hi << 32) | g();
+    }
+}
+
+/*
+    Uniform in [0, range), range > 0. Multiply-shift maps a 32-bit draw onto
+    the range; only the `2^32 mod range` lowest products are biased and those
+    are redrawn, so the common case has no division at all.
+*/
+template<class G>
+inline uint32_t bounded(G& g, uint32_t range){
+    uint64_t m = (uint64_t)next32(g) * range;
+    uint32_t low = (uint32_t)m;
+    if(low < range){
+        uint32_t threshold = -range % range;
+        while(low < threshold){
+            m = (uint64_t)next32(g) * range;
+            low = (uint32_t)m;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+template<class G>
+inline uint64_t bounded64(G& g, uint64_t range){
+    unsigned __int128 m = (unsigned __int128)next64(g) * range;
+    uint64_t low = (uint64_t)m;
+    if(low < range){
+        uint64_t threshold = -range % range;
+        while(low < threshold){
+            m = (unsigned __int128)next64(g) * range;
+            low = (uint64_t)m;
+        }
+    }
+    return (uint64_t)(m >> 64);
+}
+
+// Uniform in [low, high], both inclusive
+template<class G>
+inline int64_t uniform(G& g, int64_t low, int64_t high){
+    uint64_t range = (uint64_t)high - (uint64_t)low + 1;
+    if(range == 0)
+        return (int64_t)next64(g);                      // The whole 64-bit range
+    if(range <= 0xFFFFFFFFULL)
+        return low + bounded(g, (uint32_t)range);
+    return (int64_t)((uint64_t)low + bounded64(g, range));
+}
+
+// Uniform double in [0, 1) with 53 random bits
+template<class G>
+inline double canonical(G& g){
+    return (next64(g) >> 11) * 0x1.0p-53;
+}
+
+}
+
+#endif
@@ -1,27 +1,124 @@
 #include <iostream>
 #include <ctime>
 #include <cstdlib>
+#include <chrono>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "prng.h"
 
 using namespace std;
 
+/*
+    Uniform integers in [low, high], both inclusive, from the shared prng
+    module. A fixed seed replays the same sequence; the default seed comes from
+    random_device, not the wall clock's second.
+*/
 class Random{
     int low, high;
+    prng::Xoshiro256ss rng;
     public:
-    
-    Random(int l, int h){
+
+    Random(int l, int h, uint64_t seed=random_device{}()) : rng(seed) {
         low = l;
         high = h;
-
-        srand(time(0)); // Sets the seed to current time
     }
 
     int getRandom(){
-        return (low + rand()%high);
+        return (int)prng::uniform(rng, low, high);
     }
 };
 
+volatile uint64_t sink;
+
+template<class F>
+void bench(const string& name, long n, F draw, long drawsPerCall=1){
+    uint64_t acc = 0;
+    auto start = chrono::steady_clock::now();
+    for(long i = 0; i < n; i++)
+        acc += draw();
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / (n * drawsPerCall);
+    sink = acc;
+    cout << "  " << left << setw(34) << name << right << fixed << setprecision(2) << setw(6) << ns << " ns/draw\n";
+}
+
 int main(){
     Random r = Random(1, 5);
     for(int i = 0; i < 100; i++)
         cout << r.getRandom() << " ";
-}
\ No newline at end of file
+    cout << "\n";
+
+    cout << "\n--- Why not low + rand() % high ---\n";
+    srand(time(0));
+    int over = 0;
+    for(int i = 0; i < 100000; i++)
+        over += 3 + rand() % 5 > 5;
+    cout << "range [3, 5] via 3 + rand() % 5: " << over / 1000.0 << "% of draws land above 5\n";
+
+    // 2^32 % range values are hit twice by a modulo, and here that is a third of the range
+    const uint32_t range = 3u << 30;
+    mt19937 mt(1);
+    prng::Xoshiro256ss xo(1);
+    long lowMod = 0, lowLemire = 0, n = 3'000'000;
+    for(long i = 0; i < n; i++){
+        lowMod += mt() % range < (1u << 30);
+        lowLemire += prng::bounded(xo, range) < (1u << 30);
+    }
+    cout << "P(x < 2^30) for x in [0, 3*2^30), expect 33.33%: modulo " << setprecision(2) << 100.0 * lowMod / n
+         << "%, Lemire " << 100.0 * lowLemire / n << "%\n";
+
+    prng::Xoshiro256ss a(42), b(42);
+    Random c(1, 6, 7), d(1, 6, 7);
+    bool same = true;
+    for(int i = 0; i < 1000; i++)
+        same &= a() == b() && c.getRandom() == d.getRandom();
+    cout << "same seed, same sequence: " << (same ? "yes" : "no") << "\n";
+
+    // Lane l of the batch generator is stream l of the scalar one
+    prng::Xoshiro256ssBatch lanes(9);
+    auto scalar = prng::Xoshiro256ss::streams(9, prng::Xoshiro256ssBatch::LANES);
+    vector<uint64_t> block(8 * 1000);
+    lanes.fill(block);
+    bool match = true;
+    for(size_t i = 0; i < block.size(); i++)
+        match &= block[i] == scalar[i % 8]();
+    cout << "batch lanes match scalar streams: " << (match ? "yes" : "no") << "\n";
+
+    cout << "\n--- Raw 32/64-bit draws ---\n";
+    const long N = 50'000'000;
+    mt19937 mt32(1);
+    mt19937_64 mt64(1);
+    prng::Xoshiro256ss x(1);
+    prng::Pcg32 p(1);
+    bench("rand()", N, []{ return (uint64_t)rand(); });
+    bench("std::mt19937", N, [&]{ return (uint64_t)mt32(); });
+    bench("std::mt19937_64", N, [&]{ return mt64(); });
+    bench("prng::Pcg32", N, [&]{ return (uint64_t)p(); });
+    bench("prng::Xoshiro256ss", N, [&]{ return x(); });
+
+    prng::Xoshiro256ssBatch batch(1);
+    vector<uint64_t> buf(4096);
+    bench("prng::Xoshiro256ssBatch::fill", N / (long)buf.size(), [&]{
+        batch.fill(buf);
+        return buf[0];
+    }, buf.size());
+    cout << "\n--- Dice rolls, uniform in [1, 6] ---\n";
+    uniform_int_distribution<int> die(1, 6);
+    bench("1 + rand() % 6 (biased)", N, []{ return (uint64_t)(1 + rand() % 6); });
+    bench("uniform_int_distribution(mt19937)", N, [&]{ return (uint64_t)die(mt32); });
+    bench("prng::uniform(Pcg32)", N, [&]{ return (uint64_t)prng::uniform(p, 1, 6); });
+    bench("prng::uniform(Xoshiro256ss)", N, [&]{ return (uint64_t)prng::uniform(x, 1, 6); });
+
+    cout << "\n--- Per-thread streams ---\n";
+    auto streams = prng::Xoshiro256ss::streams(2024, 4);
+    for(size_t i = 0; i < streams.size(); i++)
+        cout << "stream " << i << " (2^128 draws apart): " << hex << streams[i]() << dec << "\n";
+    prng::Pcg32 walked(2024, 0), skipped(2024, 0), other(2024, 1);
+    for(int i = 0; i < 1000; i++)
+        walked();
+    skipped.advance(1000);
+    uint32_t w = walked(), k = skipped();
+    cout << "Pcg32 stream 0, draw 1001: " << hex << w << " stepped, " << k << " via advance(1000); stream 1, draw 1: " << other() << dec << "\n";
+}